@@ -4,144 +4,119 @@ guillotine-separable solution for the Maximum Independent Set of Rectangles (MIS
 
 The algorithm works by recursively partitioning the plane and finding the best combination of 
 non-overlapping rectangles that can be isolated by a sequence of edge-to-edge guillotine cuts.
+
+--memory-cap MB bounds the memo tables: a dense table that does not fit is replaced by a
+fixed-size, 4-way set-associative table of packed states (--memo bounded forces it). A full set
+evicts its smallest window (least width + height), the cheapest to recompute, and the least
+recently used one only among equally small windows; so the large windows stay and the small
+ones are the ones solved again when needed. The result is the same and RSS stays at the cap.
+
+--stats prints the phase times and the DP counters (states, memo hits and misses, cuts tried,
+window queries) as one JSON line per instance on stderr.
+
+The solver itself is guillotine_solver.h (solve_guillotine); this file parses the options, reads
+the instances and prints the result.
 */
 
-#include <bits/stdc++.h>
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "guillotine_solver.h"
+#include "misr.h"
 using namespace std;
+using namespace guillotine_solver;
 
-struct Rect { long long xl, yb, xr, yt; };
-struct Choice { int type = 0, param = -1; }; // 1 = leaf rect (rid), 2 = vertical cut at xi, 3 = horizontal cut at yk
-struct Answer { int val = 0; Choice ch; };
-
-struct Key {
-    int xi, xj, yk, yl;
-    bool operator==(const Key& o) const { return xi==o.xi && xj==o.xj && yk==o.yk && yl==o.yl; }
-};
-struct KeyHash {
-    size_t operator()(const Key& k) const {
-        uint64_t h = 1469598103934665603ull;
-        auto mix=[&](uint64_t v){ h^=v; h*=1099511628211ull; };
-        mix(k.xi); mix(k.xj); mix(k.yk); mix(k.yl);
-        return (size_t)h;
-    }
-};
+// Integral coordinates print as integers; others in their shortest round-trip form
+static string coord(double v) {
+    if (trunc(v) == v && fabs(v) < 9.0e18) return to_string((long long)v);
+    char buf[32];
+    return string(buf, to_chars(buf, buf + sizeof buf, v).ptr);
+}
 
-int main(){
+int main(int argc, char** argv){
     ios::sync_with_stdio(false);
-    cin.tie(nullptr);
-
-    // ---------- Read rectangles from input ----------
-    int n;
-    if (!(cin >> n) || n <= 0) {
-        cerr << "Error: first line must be a positive integer n.\n";
-        return 1;
-    }
 
-    vector<Rect> R(n);
-    for (int i = 0; i < n; ++i) {
-        if (!(cin >> R[i].xl >> R[i].yb >> R[i].xr >> R[i].yt)) {
-            cerr << "Error: line " << (i+2) << " must have 4 numbers (xl yb xr yt).\n";
-            return 1;
-        }
-        if (!(R[i].xl < R[i].xr && R[i].yb < R[i].yt)) {
-            cerr << "Error: rectangle " << i << " must satisfy xl<xr and yb<yt.\n";
+    // ---------- Parse options ----------
+    Options opts;
+    bool batch = false;           // stream of instances, one result line each
+    bool stats = false;           // one JSON line of SolveStats per instance on stderr
+    for (int a = 1; a < argc; ++a) {
+        string arg = argv[a];
+        if (arg == "--memo" && a + 1 < argc) opts.memoMode = argv[++a];
+        else if (arg == "--engine" && a + 1 < argc) opts.engine = argv[++a];
+        else if (arg == "--threads" && a + 1 < argc) opts.threads = atoi(argv[++a]);
+        else if (arg == "--no-prune") opts.prune = false;
+        else if (arg == "--no-bound") opts.bound = false;
+        else if (arg == "--no-decompose") opts.decompose = false;
+        else if (arg == "--no-reduce") opts.reduce = false;
+        else if (arg == "--batch") batch = true;
+        else if (arg == "--stats") stats = opts.timePhases = true;
+        else if (arg == "--time-limit" && a + 1 < argc) opts.timeLimit = atof(argv[++a]);
+        else if (arg == "--progress" && a + 1 < argc) opts.progressEvery = atof(argv[++a]);
+        else if (arg == "--memory-cap" && a + 1 < argc) opts.memoryCap = (size_t)(max(0.0, atof(argv[++a])) * (1 << 20));
+        else {
+            cerr << "Usage: " << argv[0] << " [--memo auto|dense|hash|bounded] [--memory-cap MB] [--engine auto|topdown|bottomup]"
+                    " [--threads N] [--no-prune] [--no-bound] [--no-decompose] [--no-reduce] [--time-limit S] [--progress S]"
+                    " [--stats] [--batch] < input\n";
             return 1;
         }
     }
-
-    // ---------- Coordinate compression ----------
-    vector<long long> xs, ys;
-    xs.reserve(2*n); ys.reserve(2*n);
-    for (auto &r : R) { xs.push_back(r.xl); xs.push_back(r.xr); ys.push_back(r.yb); ys.push_back(r.yt); }
-    sort(xs.begin(), xs.end()); xs.erase(unique(xs.begin(), xs.end()), xs.end());
-    sort(ys.begin(), ys.end()); ys.erase(unique(ys.begin(), ys.end()), ys.end());
-    const int X = (int)xs.size(), Y = (int)ys.size();   // Stores the number of unique x and y coordinates
-
-    struct RI { int xl, xr, yb, yt; };
-    vector<RI> RIv(n);
-    for (int i=0;i<n;++i){
-        RIv[i].xl = (int)(lower_bound(xs.begin(), xs.end(), R[i].xl) - xs.begin());
-        RIv[i].xr = (int)(lower_bound(xs.begin(), xs.end(), R[i].xr) - xs.begin());
-        RIv[i].yb = (int)(lower_bound(ys.begin(), ys.end(), R[i].yb) - ys.begin());
-        RIv[i].yt = (int)(lower_bound(ys.begin(), ys.end(), R[i].yt) - ys.begin());
+    const string &memoMode = opts.memoMode, &engine = opts.engine;
+    if (memoMode != "auto" && memoMode != "dense" && memoMode != "hash" && memoMode != "bounded") {
+        cerr << "Error: --memo must be one of auto, dense, hash, bounded.\n";
+        return 1;
     }
-
-    auto exactMatch = [&](int rid, int xi, int xj, int yk, int yl)->bool{
-        const auto &q = RIv[rid];
-        return q.xl==xi && q.xr==xj && q.yb==yk && q.yt==yl;
-    };   // Checks if a given window [xi, xj] × [yk, yl] exactly matches rectangle rid
-
-    //  quick “emptiness” test to exit states that contain no full rectangle
-    auto windowHasAnyRect = [&](int xi,int xj,int yk,int yl)->bool{
-        for(int rid=0; rid<n; ++rid){
-            const auto &q = RIv[rid];
-            if (q.xl>=xi && q.xr<=xj && q.yb>=yk && q.yt<=yl) return true;
-        }
-        return false;
-    };
-
-    unordered_map<Key, Answer, KeyHash> memo;
-
-    function<Answer(int,int,int,int)> solve = [&](int xi, int xj, int yk, int yl)->Answer {
-        if (xi>=xj || yk>=yl) return Answer{0,{}};
-
-        Key key{xi,xj,yk,yl};
-        if (auto it = memo.find(key); it != memo.end()) return it->second;
-
-        // If no rectangle lies fully inside this window, value is 0 (no point cutting further)
-        if (!windowHasAnyRect(xi,xj,yk,yl)) return memo[key] = Answer{0,{}};
-
-        Answer best{0,{}};
-
-        // Leaf option: if the window exactly equals some rectangle, we can take it and stop.
-        for (int rid=0; rid<n; ++rid) {
-            if (exactMatch(rid, xi, xj, yk, yl)) {
-                best = {1, {1, rid}};
-                break; 
-            }
-        }  // still try cuts; a split might yield >1 total
-
-        // Try ALL vertical cuts xi < c < xj (guillotine cut slices across; rectangles cut by it are discarded)
-        for (int c = xi+1; c <= xj-1; ++c) {
-            Answer L  = solve(xi, c, yk, yl);
-            Answer Rw = solve(c,  xj, yk, yl);
-            int v = L.val + Rw.val;
-            if (v > best.val) best = {v, {2, c}};
-        }
-
-        // Try ALL horizontal cuts yk < c < yl
-        for (int c = yk+1; c <= yl-1; ++c) {
-            Answer B = solve(xi, xj, yk, c);
-            Answer T = solve(xi, xj, c,  yl);
-            int v = B.val + T.val;
-            if (v > best.val) best = {v, {3, c}};
+    if (engine != "auto" && engine != "topdown" && engine != "bottomup") {
+        cerr << "Error: --engine must be one of auto, topdown, bottomup.\n";
+        return 1;
+    }
+    if (engine == "bottomup" && (memoMode == "hash" || memoMode == "bounded")) {
+        cerr << "Error: the bottom-up engine needs the dense memo.\n";
+        return 1;
+    }
+    vector<Workspace> ws(resolveThreads(opts.threads));
+
+    // ---------- Batch mode: "n + n rectangles" repeated until end of input ----------
+    // One line per instance: the count followed by the chosen rectangle ids (0-based)
+    InstanceReader in(0);   // stdin
+    Instance inst;
+    PhaseTimes reading;
+    PhaseTimes *readTimes = stats ? &reading : nullptr;
+    if (batch) {
+        int status;
+        while ((status = readInstance(in, inst, readTimes)) == 1) {
+            Solution sol = solve_guillotine(inst, opts, &ws);
+            if (stats) writeStatsJson(stderr, "guillotine", inst.size(), sol, readTimes);
+            reading.clear();
+            if (sol.stats.timedOut) cerr << "Note: time limit reached; returning the best solution found.\n";
+            cout << sol.selected.size();
+            for (int rid : sol.selected) cout << " " << rid;
+            cout << "\n" << flush;
         }
+        return status < 0 ? 1 : 0;
+    }
 
-        return memo[key] = best;
-    };
-
-    // Solve on global bounding window
-    Answer ans = solve(0, X-1, 0, Y-1);
+    // ---------- Read rectangles from input ----------
+    int status = readInstance(in, inst, readTimes);
+    if (status == 0) cerr << "Error: first line must be a positive integer n.\n";
+    if (status != 1) return 1;
 
-    // Reconstruct chosen rectangles
-    vector<int> chosen;
-    function<void(int,int,int,int)> recon = [&](int xi,int xj,int yk,int yl){
-        auto it = memo.find(Key{xi,xj,yk,yl});
-        if (it==memo.end()) return;
-        const auto &A = it->second;
-        if (A.val==0) return;
-        if (A.ch.type==1) { chosen.push_back(A.ch.param); return; }
-        if (A.ch.type==2) { int c=A.ch.param; recon(xi,c,yk,yl); recon(c,xj,yk,yl); return; }
-        if (A.ch.type==3) { int c=A.ch.param; recon(xi,xj,yk,c); recon(xi,xj,c,yl); return; }
-    };
-    recon(0, X-1, 0, Y-1);
+    Solution sol = solve_guillotine(inst, opts, &ws);
+    if (stats) writeStatsJson(stderr, "guillotine", inst.size(), sol, readTimes);
+    if (sol.stats.timedOut) cerr << "Note: time limit reached; returning the best solution found.\n";
 
     cout << "\n=== Best Guillotine-Separable Independent Set ===\n";
-    cout << "Rectangles selected: " << ans.val << "\n";
-    for (int rid : chosen)
-        cout << "Rect " << rid << ": (" << R[rid].xl << "," << R[rid].yb
-             << ")-(" << R[rid].xr << "," << R[rid].yt << ")\n";
+    cout << "Rectangles selected: " << sol.selected.size() << "\n";
+    if (inst.weighted) cout << "Total weight: " << sol.stats.value << "\n";
+    for (int rid : sol.selected) {
+        const InstanceRect &r = inst.rects[rid];
+        cout << "Rect " << rid << ": (" << coord(r.x1) << "," << coord(r.y1)
+             << ")-(" << coord(r.x2) << "," << coord(r.y2) << ")\n";
+    }
     
     cout << "\n";
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,55 @@
+/*
+ * Word-parallel bitset kernels for the local search.
+ *
+ * The (1,2)-swap search keeps, for every candidate around a removed rectangle, a bitset of the
+ * other candidates it conflicts with. A compatible partner of candidate i is then the first bit
+ * of (candidates & ~conflicts_i) after i, which these kernels find 256 / 512 bits at a time.
+ * The AVX2 and AVX-512 paths are picked at compile time (-mavx2 / -mavx512f, or -march=native);
+ * otherwise the portable 64-bit loop is used.
+ */
+
+#ifndef MISR_BITSET_KERNEL_H
+#define MISR_BITSET_KERNEL_H
+
+#include <cstdint>
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+inline int bitWords(int bits) { return (bits + 63) >> 6; }
+
+inline void setBit(uint64_t *row, int i) { row[i >> 6] |= uint64_t(1) << (i & 63); }
+
+// Index of the first bit at or after `from` that is set in `want` and clear in `have`, or -1
+inline int firstAndNot(const uint64_t *want, const uint64_t *have, int words, int from) {
+    int w = from >> 6;
+    if (w >= words) return -1;
+
+    // Leading partial word
+    uint64_t first = want[w] & ~have[w] & (~uint64_t(0) << (from & 63));
+    if (first) return (w << 6) + __builtin_ctzll(first);
+    ++w;
+
+#if defined(__AVX512F__)
+    for (; w + 8 <= words; w += 8) {
+        __m512i a = _mm512_loadu_si512((const void *)(want + w));
+        __m512i b = _mm512_loadu_si512((const void *)(have + w));
+        if (_mm512_test_epi64_mask(a, _mm512_xor_si512(b, _mm512_set1_epi64(-1)))) break;   // a & ~b != 0
+    }
+#elif defined(__AVX2__)
+    for (; w + 4 <= words; w += 4) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(want + w));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(have + w));
+        if (!_mm256_testc_si256(b, a)) break;   // some bit of a is not covered by b
+    }
+#endif
+
+    // Scalar tail (and the block the vector loop stopped in)
+    for (; w < words; ++w) {
+        uint64_t x = want[w] & ~have[w];
+        if (x) return (w << 6) + __builtin_ctzll(x);
+    }
+    return -1;
+}
+
+#endif // MISR_BITSET_KERNEL_H
@@ -0,0 +1,426 @@
+/*
+ * Conflict graph of a set of axis-parallel rectangles, shared by the MISR solvers.
+ *
+ * Two rectangles conflict when their interiors intersect (touching edges/corners doesn't count).
+ * Instead of testing all n^2 pairs, rectangles are bucketed into a uniform grid whose cells are
+ * about the size of a median rectangle, and only rectangles sharing a cell are tested. A pair
+ * is reported only in the cell holding the lower-left corner of its intersection, so every edge
+ * is found exactly once. Build time is proportional to n plus the number of near pairs.
+ * Rectangles covering more than max(16, n/16) cells are not bucketed; each of them is tested
+ * directly against all n rectangles, which is cheaper than filling that many cells, so a few
+ * huge or very long rectangles neither crowd the cells nor multiply the bucket entries.
+ * With integral coordinates, one rectangle is tested against 16 others of its cell at a time
+ * (overlapMask on int32 structure-of-arrays copies, rect_store.h).
+ *
+ * The result is stored in CSR form: neighbors of v are neighbors[offsets[v] .. offsets[v+1]),
+ * sorted increasingly. DynamicConflictGraph keeps one unsorted list per vertex instead, so that
+ * vertices and their edges can be added and removed in time proportional to their degrees
+ * (DynamicSolver, local_solver.h).
+ *
+ * connectedComponents splits the graph for the solvers' decomposition pre-pass: MISR is the
+ * union of independent problems on the components, so each one is solved on its own.
+ *
+ * maximalPointCliques additionally lists the sets of rectangles covering a common point that
+ * cannot be extended by moving that point (used for the clique ILP formulation).
+ */
+
+#ifndef MISR_CONFLICT_GRAPH_H
+#define MISR_CONFLICT_GRAPH_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "rect_store.h"
+
+struct ConflictGraph {
+    std::vector<int> offsets{0};   // size n+1
+    std::vector<int> neighbors;   // 2 entries per edge
+
+    int size() const { return (int)offsets.size() - 1; }
+    int degree(int v) const { return offsets[v + 1] - offsets[v]; }
+    size_t edgeCount() const { return neighbors.size() / 2; }
+    const int* begin(int v) const { return neighbors.data() + offsets[v]; }
+    const int* end(int v) const { return neighbors.data() + offsets[v + 1]; }
+
+    bool adjacent(int u, int v) const { return std::binary_search(begin(u), end(u), v); }
+};
+
+// Adjacency lists that change one vertex at a time. A removed vertex keeps its id with no edges.
+struct DynamicConflictGraph {
+    std::vector<std::vector<int>> rows;
+
+    DynamicConflictGraph() = default;
+    explicit DynamicConflictGraph(const ConflictGraph &g) : rows(g.size()) {
+        for (int v = 0; v < g.size(); ++v) rows[v].assign(g.begin(v), g.end(v));
+    }
+
+    int size() const { return (int)rows.size(); }
+    int degree(int v) const { return (int)rows[v].size(); }
+    const int* begin(int v) const { return rows[v].data(); }
+    const int* end(int v) const { return rows[v].data() + rows[v].size(); }
+
+    // New vertex adjacent to `neighbors`; returns its id
+    int addVertex(const std::vector<int> &neighbors) {
+        const int v = size();
+        rows.emplace_back(neighbors);
+        for (int u : neighbors) rows[u].push_back(v);
+        return v;
+    }
+    // Drops every edge of v
+    void isolate(int v) {
+        for (int u : rows[v]) {
+            std::vector<int> &r = rows[u];
+            *std::find(r.begin(), r.end(), v) = r.back();
+            r.pop_back();
+        }
+        std::vector<int>().swap(rows[v]);
+    }
+};
+
+// Builds the CSR graph from an undirected edge list over n vertices into g (storage is reused)
+inline void conflictGraphFromEdges(int n, const std::vector<std::pair<int,int>> &edges, ConflictGraph &g) {
+    g.offsets.assign(n + 1, 0);
+    for (const auto &e : edges) { ++g.offsets[e.first + 1]; ++g.offsets[e.second + 1]; }
+    for (int v = 0; v < n; ++v) g.offsets[v + 1] += g.offsets[v];
+
+    g.neighbors.resize(2 * edges.size());
+    std::vector<int> fill(g.offsets.begin(), g.offsets.end() - 1);
+    for (const auto &e : edges) {
+        g.neighbors[fill[e.first]++] = e.second;
+        g.neighbors[fill[e.second]++] = e.first;
+    }
+    for (int v = 0; v < n; ++v) std::sort(g.neighbors.begin() + g.offsets[v], g.neighbors.begin() + g.offsets[v + 1]);
+}
+
+inline ConflictGraph conflictGraphFromEdges(int n, const std::vector<std::pair<int,int>> &edges) {
+    ConflictGraph g;
+    conflictGraphFromEdges(n, edges, g);
+    return g;
+}
+
+// Grid-bucketed pair finder. Keeping one builder alive across instances (--batch) reuses the
+// bucket arrays and the edge list instead of reallocating them every time.
+struct ConflictGraphBuilder {
+    std::vector<std::pair<int,int>> edges;   // result of the last pairs() call
+    std::vector<int> cx1, cy1, cx2, cy2, bucket;
+    std::vector<size_t> start, fill;
+    RectSoA cells;                             // int32 coordinates in bucket order
+    std::vector<double> extent;                // widths, then heights, for the median
+    std::vector<int> large;                    // rectangles tested against all others, not bucketed
+    std::vector<char> isLarge;
+    RectSoA flat;                              // int32 coordinates in id order, when there are large ones
+    std::vector<std::pair<int,int>> scratch;
+    std::vector<size_t> runs;
+
+    // All conflicting pairs (i, j) with i < j, sorted unless sorted = false. R needs members
+    // x1, y1, x2, y2 with x1 < x2, y1 < y2.
+    template <class R>
+    const std::vector<std::pair<int,int>> &pairs(const std::vector<R> &rects, bool sorted = true);
+
+    // The CSR build sorts every neighbor list itself, so it skips sorting the edge list
+    template <class R>
+    void build(const std::vector<R> &rects, ConflictGraph &g) {
+        conflictGraphFromEdges((int)rects.size(), pairs(rects, false), g);
+    }
+
+private:
+    // Counting sort by the first vertex, then each (short) run by the second
+    void sortPairs(int n) {
+        runs.assign(n + 1, 0);
+        for (const auto &e : edges) ++runs[e.first + 1];
+        for (int v = 0; v < n; ++v) runs[v + 1] += runs[v];
+        scratch.resize(edges.size());
+        for (const auto &e : edges) scratch[runs[e.first]++] = e;   // runs[v] ends up at run v+1's start
+        for (int v = n; v > 0; --v) runs[v] = runs[v - 1];
+        runs[0] = 0;
+        for (int v = 0; v < n; ++v) std::sort(scratch.begin() + runs[v], scratch.begin() + runs[v + 1]);
+        edges.swap(scratch);
+    }
+};
+
+template <class R>
+const std::vector<std::pair<int,int>> &ConflictGraphBuilder::pairs(const std::vector<R> &rects, bool sorted) {
+    const int n = (int)rects.size();
+    edges.clear();
+    if (n < 2) return edges;
+
+    // ---------- Grid geometry ----------
+    double minX = rects[0].x1, maxX = rects[0].x2, minY = rects[0].y1, maxY = rects[0].y2;
+    for (const auto &r : rects) {
+        minX = std::min<double>(minX, r.x1); maxX = std::max<double>(maxX, r.x2);
+        minY = std::min<double>(minY, r.y1); maxY = std::max<double>(maxY, r.y2);
+    }
+    // Median side lengths; unlike the mean, a few huge rectangles do not inflate them
+    auto median = [&](auto side) {
+        extent.resize(n);
+        for (int i = 0; i < n; ++i) extent[i] = side(rects[i]);
+        std::nth_element(extent.begin(), extent.begin() + n / 2, extent.end());
+        return extent[n / 2];
+    };
+    const double medW = median([](const R &r) { return (double)(r.x2 - r.x1); });
+    const double medH = median([](const R &r) { return (double)(r.y2 - r.y1); });
+    // Cells about one median rectangle wide, capped at ~4n cells in total
+    double gx = std::max(1.0, std::floor((maxX - minX) / medW));
+    double gy = std::max(1.0, std::floor((maxY - minY) / medH));
+    if (gx * gy > 4.0 * n) {
+        double shrink = std::sqrt(gx * gy / (4.0 * n));
+        gx = std::max(1.0, std::floor(gx / shrink));
+        gy = std::max(1.0, std::floor(gy / shrink));
+    }
+    const int GX = (int)gx, GY = (int)gy;
+    const double sx = GX / (maxX - minX), sy = GY / (maxY - minY);
+    auto cellX = [&](double x) { return std::min(GX - 1, (int)((x - minX) * sx)); };
+    auto cellY = [&](double y) { return std::min(GY - 1, (int)((y - minY) * sy)); };
+
+    // ---------- Bucket rectangles into every cell they cover (CSR), except the large ones ----------
+    const double largeCells = std::max(16.0, n / 16.0);
+    cx1.resize(n); cy1.resize(n); cx2.resize(n); cy2.resize(n);
+    large.clear();
+    isLarge.assign(n, 0);
+    start.assign((size_t)GX * GY + 1, 0);
+    for (int i = 0; i < n; ++i) {
+        cx1[i] = cellX(rects[i].x1); cx2[i] = cellX(rects[i].x2);
+        cy1[i] = cellY(rects[i].y1); cy2[i] = cellY(rects[i].y2);
+        if ((double)(cx2[i] - cx1[i] + 1) * (cy2[i] - cy1[i] + 1) > largeCells) {
+            isLarge[i] = 1;
+            large.push_back(i);
+            continue;
+        }
+        for (int cx = cx1[i]; cx <= cx2[i]; ++cx)
+            for (int cy = cy1[i]; cy <= cy2[i]; ++cy) ++start[(size_t)cx * GY + cy + 1];
+    }
+    for (size_t c = 0; c + 1 < start.size(); ++c) start[c + 1] += start[c];
+    bucket.resize(start.back());
+    fill.assign(start.begin(), start.end() - 1);
+    for (int i = 0; i < n; ++i) {
+        if (isLarge[i]) continue;
+        for (int cx = cx1[i]; cx <= cx2[i]; ++cx)
+            for (int cy = cy1[i]; cy <= cy2[i]; ++cy) bucket[fill[(size_t)cx * GY + cy]++] = i;
+    }
+
+    // ---------- int32 coordinates in bucket order (rect_store.h), when exact ----------
+    bool packed = true;
+    for (const auto &r : rects)
+        packed = packed && fitsInt32(r.x1) && fitsInt32(r.y1) && fitsInt32(r.x2) && fitsInt32(r.y2);
+    if (packed) {
+        cells.resize(bucket.size());
+        for (size_t k = 0; k < bucket.size(); ++k) {
+            const auto &r = rects[bucket[k]];
+            cells.set(k, (int32_t)r.x1, (int32_t)r.y1, (int32_t)r.x2, (int32_t)r.y2);
+        }
+    }
+
+    // ---------- Test pairs within each cell ----------
+    auto report = [&](int a, int b, int cx, int cy) {
+        // Report the pair only in the cell of the intersection's lower-left corner
+        if (std::max(cx1[a], cx1[b]) != cx || std::max(cy1[a], cy1[b]) != cy) return;
+        edges.push_back(a < b ? std::make_pair(a, b) : std::make_pair(b, a));
+    };
+    for (int cx = 0; cx < GX; ++cx)
+        for (int cy = 0; cy < GY; ++cy) {
+            const size_t c = (size_t)cx * GY + cy;
+            for (size_t p = start[c]; p < start[c + 1]; ++p) {
+                const int a = bucket[p];
+                if (packed) {
+                    // One rectangle against the next 16 of the cell at a time
+                    for (size_t q = p + 1; q < start[c + 1]; q += 16) {
+                        uint32_t hits = overlapMask(cells.x1[p], cells.y1[p], cells.x2[p], cells.y2[p], cells, q,
+                                                    (int)std::min<size_t>(16, start[c + 1] - q));
+                        for (; hits; hits &= hits - 1) report(a, bucket[q + __builtin_ctz(hits)], cx, cy);
+                    }
+                    continue;
+                }
+                const auto &ra = rects[a];
+                for (size_t q = p + 1; q < start[c + 1]; ++q) {
+                    const auto &rb = rects[bucket[q]];
+                    if (std::min(ra.x2, rb.x2) <= std::max(ra.x1, rb.x1)) continue;
+                    if (std::min(ra.y2, rb.y2) <= std::max(ra.y1, rb.y1)) continue;
+                    report(a, bucket[q], cx, cy);
+                }
+            }
+        }
+
+    // ---------- Large rectangles against all others ----------
+    // A pair of large rectangles is reported by the one with the smaller id
+    auto reportLarge = [&](int a, int b) {
+        if (b == a || (isLarge[b] && b < a)) return;
+        edges.push_back(a < b ? std::make_pair(a, b) : std::make_pair(b, a));
+    };
+    if (!large.empty() && packed) {
+        flat.resize(n);
+        for (int i = 0; i < n; ++i)
+            flat.set(i, (int32_t)rects[i].x1, (int32_t)rects[i].y1, (int32_t)rects[i].x2, (int32_t)rects[i].y2);
+    }
+    for (int a : large) {
+        if (packed) {
+            for (int q = 0; q < n; q += 16) {
+                uint32_t hits = overlapMask(flat.x1[a], flat.y1[a], flat.x2[a], flat.y2[a], flat, q, std::min(16, n - q));
+                for (; hits; hits &= hits - 1) reportLarge(a, q + __builtin_ctz(hits));
+            }
+            continue;
+        }
+        const auto &ra = rects[a];
+        for (int b = 0; b < n; ++b) {
+            const auto &rb = rects[b];
+            if (std::min(ra.x2, rb.x2) <= std::max(ra.x1, rb.x1)) continue;
+            if (std::min(ra.y2, rb.y2) <= std::max(ra.y1, rb.y1)) continue;
+            reportLarge(a, b);
+        }
+    }
+    if (sorted) sortPairs(n);
+    return edges;
+}
+
+template <class R>
+std::vector<std::pair<int,int>> findConflictPairs(const std::vector<R> &rects) {
+    ConflictGraphBuilder builder;
+    builder.pairs(rects);
+    return std::move(builder.edges);
+}
+
+template <class R>
+ConflictGraph buildConflictGraph(const std::vector<R> &rects) {
+    ConflictGraph g;
+    ConflictGraphBuilder().build(rects, g);
+    return g;
+}
+
+// Connected components (union-find over the edges) in CSR form: component c is
+// members[offsets[c] .. offsets[c+1]), sorted, and components are ordered by their smallest
+// member; isolated vertices form singletons. Three arrays however many components there are.
+inline void connectedComponents(const ConflictGraph &g, std::vector<int> &offsets, std::vector<int> &members) {
+    const int n = g.size();
+    std::vector<int> parent(n);
+    for (int v = 0; v < n; ++v) parent[v] = v;
+    auto find = [&](int v) {
+        while (parent[v] != v) v = parent[v] = parent[parent[v]];   // path halving
+        return v;
+    };
+    for (int u = 0; u < n; ++u)
+        for (const int *p = g.begin(u); p != g.end(u); ++p) {
+            int a = find(u), b = find(*p);
+            if (a != b) parent[std::max(a, b)] = std::min(a, b);   // root = smallest member
+        }
+
+    // Roots are the smallest members, so numbering them in vertex order orders the components
+    std::vector<int> slot(n);   // component of v
+    offsets.assign(1, 0);
+    for (int v = 0; v < n; ++v) {
+        const int r = find(v);
+        if (r == v) { slot[v] = (int)offsets.size() - 1; offsets.push_back(0); }
+        else slot[v] = slot[r];
+        ++offsets[slot[v] + 1];
+    }
+    for (size_t c = 1; c < offsets.size(); ++c) offsets[c] += offsets[c - 1];
+    members.resize(n);
+    std::vector<int> fill(offsets.begin(), offsets.end() - 1);
+    for (int v = 0; v < n; ++v) members[fill[slot[v]]++] = v;
+}
+
+inline std::vector<std::vector<int>> connectedComponents(const ConflictGraph &g) {
+    std::vector<int> offsets, members;
+    connectedComponents(g, offsets, members);
+    std::vector<std::vector<int>> comps(offsets.size() - 1);
+    for (size_t c = 0; c < comps.size(); ++c) comps[c].assign(members.begin() + offsets[c], members.begin() + offsets[c + 1]);
+    return comps;
+}
+
+// Subgraph induced by the k sorted `members` into sub (keeping its capacity), relabelled
+// 0..k-1 in the order of `members`
+inline void inducedSubgraph(const ConflictGraph &g, const int *members, size_t k, ConflictGraph &sub) {
+    sub.offsets.assign(k + 1, 0);
+    sub.neighbors.clear();
+    for (size_t i = 0; i < k; ++i) {
+        const int v = members[i];
+        for (const int *p = g.begin(v); p != g.end(v); ++p) {
+            const int *it = std::lower_bound(members, members + k, *p);
+            if (it != members + k && *it == *p) sub.neighbors.push_back((int)(it - members));
+        }
+        sub.offsets[i + 1] = (int)sub.neighbors.size();
+    }
+}
+
+inline ConflictGraph inducedSubgraph(const ConflictGraph &g, const std::vector<int> &members) {
+    ConflictGraph sub;
+    inducedSubgraph(g, members.data(), members.size(), sub);
+    return sub;
+}
+
+// Sweeps the plane left to right. Between two consecutive x coordinates the set of rectangles
+// spanning the slab only grows at starts and shrinks at ends, so a slab is worth examining only
+// when some start happened since the last end and a rectangle ends at its right boundary.
+// Inside such a slab the same rule over y yields the locally maximal point cliques. Every
+// overlapping pair shares the first such slab of its x-overlap, so the cliques cover all
+// conflict edges. Cliques are sorted, deduplicated and have at least two members.
+template <class R>
+std::vector<std::vector<int>> maximalPointCliques(const std::vector<R> &rects) {
+    const int n = (int)rects.size();
+    struct Event { double at; int type; int id; };   // type 0 = end, 1 = start: ends first at ties
+    std::vector<Event> xe;
+    xe.reserve(2 * n);
+    for (int i = 0; i < n; ++i) { xe.push_back({rects[i].x1, 1, i}); xe.push_back({rects[i].x2, 0, i}); }
+    std::sort(xe.begin(), xe.end(), [](const Event &a, const Event &b) {
+        return a.at != b.at ? a.at < b.at : a.type < b.type;
+    });
+
+    struct VecHash {
+        size_t operator()(const std::vector<int> &v) const {
+            uint64_t h = 1469598103934665603ull;
+            for (int x : v) { h ^= (uint64_t)x; h *= 1099511628211ull; }
+            return (size_t)h;
+        }
+    };
+    std::unordered_set<std::vector<int>, VecHash> seen;
+    std::vector<std::vector<int>> cliques;
+
+    std::vector<int> active, pos(n, -1);   // rectangles spanning the current slab (swap-remove)
+    auto add = [&](int id) { pos[id] = (int)active.size(); active.push_back(id); };
+    auto drop = [&](int id) {
+        int p = pos[id];
+        pos[active.back()] = p; active[p] = active.back(); active.pop_back(); pos[id] = -1;
+    };
+
+    std::vector<Event> ye;
+    std::vector<int> column;
+    std::vector<int> ypos(n, -1);
+    auto emitSlab = [&]() {
+        ye.clear();
+        for (int id : active) { ye.push_back({rects[id].y1, 1, id}); ye.push_back({rects[id].y2, 0, id}); }
+        std::sort(ye.begin(), ye.end(), [](const Event &a, const Event &b) {
+            return a.at != b.at ? a.at < b.at : a.type < b.type;
+        });
+        column.clear();
+        bool grew = false;
+        for (const Event &e : ye) {
+            if (e.type == 1) { ypos[e.id] = (int)column.size(); column.push_back(e.id); grew = true; continue; }
+            if (grew && column.size() >= 2) {
+                std::vector<int> c(column);
+                std::sort(c.begin(), c.end());
+                if (seen.insert(c).second) cliques.push_back(std::move(c));
+            }
+            grew = false;
+            int p = ypos[e.id];
+            ypos[column.back()] = p; column[p] = column.back(); column.pop_back(); ypos[e.id] = -1;
+        }
+    };
+
+    bool grew = false;
+    for (size_t k = 0; k < xe.size(); ) {
+        // All events at one x coordinate: the slab to the left ends here
+        size_t next = k;
+        bool endsHere = false;
+        while (next < xe.size() && xe[next].at == xe[k].at) endsHere |= xe[next++].type == 0;
+        if (endsHere && grew) emitSlab();
+        if (endsHere) grew = false;
+        for (; k < next; ++k) {
+            if (xe[k].type == 0) drop(xe[k].id);
+            else { add(xe[k].id); grew = true; }
+        }
+    }
+    return cliques;
+}
+
+#endif // MISR_CONFLICT_GRAPH_H
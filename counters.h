@@ -0,0 +1,83 @@
+/*
+ * Event counters of the solvers (--stats, SolveStats::counters).
+ *
+ * Inner loops count into a plain Tally owned by one thread (a DP, a LocalSearch, a worker) and
+ * add it to the run's Counters once per task, so the hot paths never touch shared memory.
+ * Tally::add is an `if constexpr` on MISR_COUNTERS: building with -DMISR_COUNTERS=0 removes
+ * every counting statement, and the counters then read zero ("counters_enabled": false).
+ */
+
+#ifndef MISR_COUNTERS_H
+#define MISR_COUNTERS_H
+
+#include <atomic>
+#include <cstdint>
+
+#ifndef MISR_COUNTERS
+#define MISR_COUNTERS 1
+#endif
+
+constexpr bool COUNTERS_ENABLED = MISR_COUNTERS != 0;
+
+enum Counter {
+    CTR_DP_STATES,        // guillotine: memo entries written
+    CTR_MEMO_HITS,        // guillotine: top-down memo lookups that found the window
+    CTR_MEMO_MISSES,      // guillotine: top-down memo lookups that did not
+    CTR_MEMO_EVICTIONS,   // guillotine: windows dropped by the memory-capped memo
+    CTR_CUTS_TRIED,       // guillotine: candidate cuts left after pruning
+    CTR_WINDOW_QUERIES,   // guillotine: windowHasAnyRect calls
+    CTR_CONFLICT_EDGES,   // conflict-graph edges of the instance
+    CTR_BB_NODES,         // ILP: branch-and-bound nodes created by GLPK
+    CTR_TRIED_0_1,        // local search: free rectangles examined / inserted
+    CTR_APPLIED_0_1,
+    CTR_TRIED_1_1,        // weighted: heaviest 1-tight neighbor checked / swapped in
+    CTR_APPLIED_1_1,
+    CTR_TRIED_1_2,        // pair searches around a solution member / pairs swapped in
+    CTR_APPLIED_1_2,
+    CTR_TRIED_2_1,        // weighted: 2-tight neighbors checked / swapped in
+    CTR_APPLIED_2_1,
+    CTR_TRIED_K,          // (k, k+1): removal sets tried / replaced
+    CTR_APPLIED_K,
+    CTR_COUNT
+};
+
+inline const char *counterName(int counter) {
+    static const char *const names[CTR_COUNT] = {
+        "dp_states", "memo_hits", "memo_misses", "memo_evictions", "cuts_tried", "window_has_any_rect",
+        "conflict_edges", "bb_nodes",
+        "moves_0_1_tried", "moves_0_1_applied", "moves_1_1_tried", "moves_1_1_applied",
+        "moves_1_2_tried", "moves_1_2_applied", "moves_2_1_tried", "moves_2_1_applied",
+        "moves_k_tried", "moves_k_applied"};
+    return names[counter];
+}
+
+// Counts of one thread
+struct Tally {
+    uint64_t n[CTR_COUNT] = {};
+
+    void add(Counter c, uint64_t k = 1) {
+        if constexpr (COUNTERS_ENABLED) n[c] += k;
+    }
+    void clear() {
+        if constexpr (COUNTERS_ENABLED) for (uint64_t &v : n) v = 0;
+    }
+};
+
+// Counts of one run, summed over its tasks
+struct Counters {
+    std::atomic<uint64_t> n[CTR_COUNT] = {};
+
+    void add(Counter c, uint64_t k) {
+        if constexpr (COUNTERS_ENABLED) n[c].fetch_add(k, std::memory_order_relaxed);
+    }
+    void add(const Tally &t) {
+        if constexpr (COUNTERS_ENABLED)
+            for (int c = 0; c < CTR_COUNT; ++c)
+                if (t.n[c]) n[c].fetch_add(t.n[c], std::memory_order_relaxed);
+    }
+    void copyTo(uint64_t (&out)[CTR_COUNT]) const {
+        for (int c = 0; c < CTR_COUNT; ++c) out[c] = n[c].load(std::memory_order_relaxed);
+    }
+};
+
+#endif // MISR_COUNTERS_H
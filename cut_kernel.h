@@ -0,0 +1,141 @@
+/*
+ * Cut kernel of the bottom-up guillotine DP.
+ *
+ * Without pruning, the cuts of a window in one direction are all of its interior coordinates,
+ * and both halves of every cut are already in the dense memo. The value of a cut is the sum of
+ * two packed answer words (AnswerCodec: the count above the choice bits), whose positions in the
+ * table follow from precomputed per-cut offsets. maxPairSum gathers, shifts, adds and compares
+ * 8 (AVX2) or 16 (AVX-512) cuts of uint32 words at a time, 4 or 8 of uint64 words, and returns
+ * the first cut reaching the maximum, the one the scalar loop would keep. The vector paths are
+ * picked at compile time (-mavx2 / -mavx512f, or -march=native), like bitset_kernel.h;
+ * otherwise the portable loop is used.
+ */
+
+#ifndef MISR_CUT_KERNEL_H
+#define MISR_CUT_KERNEL_H
+
+#include <cstdint>
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+struct CutMax { int64_t val = -1; int at = -1; };   // largest sum and its first index, -1 for none
+
+// Portable loop from index `from` on, continuing `best`
+template <class Word, class Index>
+inline CutMax maxPairSumFrom(const Word *a, const Index *ia, const Word *b, const Index *ib, int from, int count,
+                             int shift, CutMax best) {
+    for (int i = from; i < count; ++i) {
+        int64_t s = (int64_t)(a[ia[i]] >> shift) + (int64_t)(b[ib[i]] >> shift);
+        if (s > best.val) best = {s, i};
+    }
+    return best;
+}
+
+// Per-lane maxima and their first indices to one CutMax: the largest value, then the lowest index
+template <class T, int N>
+inline CutMax reduceLanes(const T (&val)[N], const T (&at)[N]) {
+    CutMax best;
+    for (int l = 0; l < N; ++l)
+        if (val[l] > best.val || (val[l] == best.val && at[l] < best.at)) best = {(int64_t)val[l], (int)at[l]};
+    return best;
+}
+
+// Largest (a[ia[i]] >> shift) + (b[ib[i]] >> shift) over i < count, and the first i reaching it
+inline CutMax maxPairSum(const uint32_t *a, const int32_t *ia, const uint32_t *b, const int32_t *ib, int count,
+                         int shift) {
+    CutMax best;
+    int i = 0;
+#if defined(__AVX512F__)
+    if (count >= 16) {
+        const __m128i sh = _mm_cvtsi32_si128(shift);
+        __m512i top = _mm512_set1_epi32(-1), at = _mm512_setzero_si512();
+        const __m512i zero = _mm512_setzero_si512();   // masked forms: GCC 12 warns about the undefined source of the unmasked ones
+        const __mmask16 all = 0xFFFF;
+        __m512i lane = _mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+        for (; i + 16 <= count; i += 16) {
+            __m512i va = _mm512_mask_i32gather_epi32(zero, all, _mm512_loadu_si512((const void *)(ia + i)), (const void *)a, 4);
+            __m512i vb = _mm512_mask_i32gather_epi32(zero, all, _mm512_loadu_si512((const void *)(ib + i)), (const void *)b, 4);
+            __m512i s = _mm512_add_epi32(_mm512_maskz_srl_epi32(all, va, sh), _mm512_maskz_srl_epi32(all, vb, sh));
+            __mmask16 gt = _mm512_cmpgt_epi32_mask(s, top);
+            top = _mm512_mask_mov_epi32(top, gt, s);
+            at = _mm512_mask_mov_epi32(at, gt, lane);
+            lane = _mm512_add_epi32(lane, _mm512_set1_epi32(16));
+        }
+        alignas(64) int32_t tv[16], ta[16];
+        _mm512_store_si512((void *)tv, top);
+        _mm512_store_si512((void *)ta, at);
+        best = reduceLanes(tv, ta);
+    }
+#elif defined(__AVX2__)
+    if (count >= 8) {
+        const __m128i sh = _mm_cvtsi32_si128(shift);
+        __m256i top = _mm256_set1_epi32(-1), at = _mm256_setzero_si256();
+        __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        for (; i + 8 <= count; i += 8) {
+            __m256i va = _mm256_i32gather_epi32((const int *)a, _mm256_loadu_si256((const __m256i *)(ia + i)), 4);
+            __m256i vb = _mm256_i32gather_epi32((const int *)b, _mm256_loadu_si256((const __m256i *)(ib + i)), 4);
+            __m256i s = _mm256_add_epi32(_mm256_srl_epi32(va, sh), _mm256_srl_epi32(vb, sh));
+            __m256i gt = _mm256_cmpgt_epi32(s, top);
+            top = _mm256_blendv_epi8(top, s, gt);
+            at = _mm256_blendv_epi8(at, lane, gt);
+            lane = _mm256_add_epi32(lane, _mm256_set1_epi32(8));
+        }
+        alignas(32) int32_t tv[8], ta[8];
+        _mm256_store_si256((__m256i *)tv, top);
+        _mm256_store_si256((__m256i *)ta, at);
+        best = reduceLanes(tv, ta);
+    }
+#endif
+    return maxPairSumFrom(a, ia, b, ib, i, count, shift, best);
+}
+
+inline CutMax maxPairSum(const uint64_t *a, const int64_t *ia, const uint64_t *b, const int64_t *ib, int count,
+                         int shift) {
+    CutMax best;
+    int i = 0;
+#if defined(__AVX512F__)
+    if (count >= 8) {
+        const __m128i sh = _mm_cvtsi32_si128(shift);
+        __m512i top = _mm512_set1_epi64(-1), at = _mm512_setzero_si512();
+        const __m512i zero = _mm512_setzero_si512();
+        const __mmask8 all = 0xFF;
+        __m512i lane = _mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0);
+        for (; i + 8 <= count; i += 8) {
+            __m512i va = _mm512_mask_i64gather_epi64(zero, all, _mm512_loadu_si512((const void *)(ia + i)), (const void *)a, 8);
+            __m512i vb = _mm512_mask_i64gather_epi64(zero, all, _mm512_loadu_si512((const void *)(ib + i)), (const void *)b, 8);
+            __m512i s = _mm512_add_epi64(_mm512_maskz_srl_epi64(all, va, sh), _mm512_maskz_srl_epi64(all, vb, sh));
+            __mmask8 gt = _mm512_cmpgt_epi64_mask(s, top);
+            top = _mm512_mask_mov_epi64(top, gt, s);
+            at = _mm512_mask_mov_epi64(at, gt, lane);
+            lane = _mm512_add_epi64(lane, _mm512_set1_epi64(8));
+        }
+        alignas(64) int64_t tv[8], ta[8];
+        _mm512_store_si512((void *)tv, top);
+        _mm512_store_si512((void *)ta, at);
+        best = reduceLanes(tv, ta);
+    }
+#elif defined(__AVX2__)
+    if (count >= 4) {
+        const __m128i sh = _mm_cvtsi32_si128(shift);
+        __m256i top = _mm256_set1_epi64x(-1), at = _mm256_setzero_si256();
+        __m256i lane = _mm256_setr_epi64x(0, 1, 2, 3);
+        for (; i + 4 <= count; i += 4) {
+            __m256i va = _mm256_i64gather_epi64((const long long *)a, _mm256_loadu_si256((const __m256i *)(ia + i)), 8);
+            __m256i vb = _mm256_i64gather_epi64((const long long *)b, _mm256_loadu_si256((const __m256i *)(ib + i)), 8);
+            __m256i s = _mm256_add_epi64(_mm256_srl_epi64(va, sh), _mm256_srl_epi64(vb, sh));
+            __m256i gt = _mm256_cmpgt_epi64(s, top);
+            top = _mm256_blendv_epi8(top, s, gt);
+            at = _mm256_blendv_epi8(at, lane, gt);
+            lane = _mm256_add_epi64(lane, _mm256_set1_epi64x(4));
+        }
+        alignas(32) int64_t tv[4], ta[4];
+        _mm256_store_si256((__m256i *)tv, top);
+        _mm256_store_si256((__m256i *)ta, at);
+        best = reduceLanes(tv, ta);
+    }
+#endif
+    return maxPairSumFrom(a, ia, b, ib, i, count, shift, best);
+}
+
+#endif // MISR_CUT_KERNEL_H
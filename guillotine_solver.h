@@ -0,0 +1,965 @@
+/*
+ * Guillotine DP solver library (see Guillotine_Cut_MISR.cpp for the CLI).
+ *
+ * solve_guillotine finds the best guillotine-separable independent set of an Instance (misr.h):
+ * the maximum count, or the maximum total weight when the instance is weighted. The DP only
+ * compares coordinates, so it runs on the instance's ranks and accepts any real coordinates.
+ *
+ * Pipeline: rectangles containing another one are dropped (reduce.h), the rest is split at free
+ * cuts into independent blocks, and each block is solved by the O(n^5) recurrence on its own
+ * compressed grid, top-down over a dense or hash memo or bottom-up by window size, with cut
+ * pruning and upper bounds (without pruning, bottom-up cuts are max-reduced by cut_kernel.h).
+ * Blocks run in parallel on Options::threads workers.
+ */
+
+#ifndef MISR_GUILLOTINE_SOLVER_H
+#define MISR_GUILLOTINE_SOLVER_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "conflict_graph.h"
+#include "counters.h"
+#include "cut_kernel.h"
+#include "misr.h"
+#include "parallel.h"
+#include "phase_times.h"
+#include "reduce.h"
+#include "time_budget.h"
+
+namespace guillotine_solver {
+
+using namespace std;
+
+
+struct Rect { long long xl, yb, xr, yt; double w = 1; };
+struct Choice { int type = 0, param = -1; }; // 1 = leaf rect (rid, -1 if not stored), 2 = vertical cut at xi, 3 = horizontal cut at yk
+// V is int (rectangle count) for unweighted instances and double (weight sum) for weighted ones
+template <class V> struct Answer { V val = 0; Choice ch; };
+
+struct Key {
+    int xi, xj, yk, yl;
+    bool operator==(const Key& o) const { return xi==o.xi && xj==o.xj && yk==o.yk && yl==o.yl; }
+};
+struct KeyHash {
+    size_t operator()(const Key& k) const {
+        uint64_t h = 1469598103934665603ull;
+        auto mix=[&](uint64_t v){ h^=v; h*=1099511628211ull; };
+        mix(k.xi); mix(k.xj); mix(k.yk); mix(k.yl);
+        return (size_t)h;
+    }
+};
+
+// Compact state encodings, picked at compile time from the coordinate type C of a block's grid:
+// uint8_t when X, Y <= 256, uint16_t when X, Y <= 65536, and uint32_t (the plain Key and Answer)
+// beyond. A window packs into one uint32 / uint64 word.
+template <class C>
+struct StateKey {
+    static constexpr int BITS = 8 * sizeof(C);
+    using Word = conditional_t<sizeof(C) == 1, uint32_t, uint64_t>;
+    struct Hash {
+        size_t operator()(Word k) const { uint64_t h = (uint64_t)k * 0x9E3779B97F4A7C15ull; return (size_t)(h ^ (h >> 32)); }
+    };
+    static Word pack(int xi, int xj, int yk, int yl) {
+        return (((Word)xi << BITS | (Word)xj) << BITS | (Word)yk) << BITS | (Word)yl;
+    }
+};
+template <>
+struct StateKey<uint32_t> {
+    using Word = Key;
+    using Hash = KeyHash;
+    static Word pack(int xi, int xj, int yk, int yl) { return Key{xi, xj, yk, yl}; }
+};
+
+// Memoized answers in the same width. A count packs into one word: the value above the 2-bit
+// choice type and the cut coordinate. Leaves drop their rectangle id, which is the exactMatch of
+// the window (recon looks it up again). Weighted answers and wider grids stay unpacked, since a
+// double needs all 64 bits of its own.
+template <class V, class C, class = void>
+struct AnswerCodec {
+    using Word = Answer<V>;
+    static Word empty() { return Word{-1, {}}; }   // values are >= 0
+    static bool isEmpty(const Word &w) { return w.val < 0; }
+    static Word pack(const Answer<V> &a) { return a; }
+    static Answer<V> unpack(const Word &w) { return w; }
+};
+template <class C>
+struct AnswerCodec<int, C, enable_if_t<sizeof(C) <= 2>> {
+    static constexpr int CUT_BITS = 8 * sizeof(C), VALUE_SHIFT = CUT_BITS + 2;
+    using Word = typename StateKey<C>::Word;   // leaves 22 (uint8) or 46 value bits, far above (X-1)(Y-1)
+    static Word empty() { return ~Word(0); }
+    static bool isEmpty(Word w) { return w == empty(); }
+    static Word pack(const Answer<int> &a) {
+        return (Word)a.val << VALUE_SHIFT | (Word)a.ch.type << CUT_BITS | (Word)(a.ch.type >= 2 ? a.ch.param : 0);
+    }
+    static Answer<int> unpack(Word w) {
+        const int type = (int)(w >> CUT_BITS) & 3;
+        return {(int)(w >> VALUE_SHIFT), {type, type >= 2 ? (int)(w & ((Word(1) << CUT_BITS) - 1)) : -1}};
+    }
+};
+
+// Compressed rectangle: indices into the sorted unique x / y coordinate lists
+struct RI { int xl, xr, yb, yt; };
+
+// Triangular packing of the coordinate pairs i<j over m compressed coordinates
+struct PairIndex {
+    size_t count = 0;
+    vector<size_t> off;   // off[i] = packed index of the pair (i, i+1)
+
+    static size_t pairCount(int m) { return m < 2 ? 0 : (size_t)m * (m - 1) / 2; }
+
+    explicit PairIndex(int m) : count(pairCount(m)), off(max(m, 1)) {
+        size_t acc = 0;
+        for (int i = 0; i < m; ++i) { off[i] = acc; acc += (size_t)(m - 1 - i); }
+    }
+    size_t operator()(int i, int j) const { return off[i] + (size_t)(j - i - 1); }
+};
+
+// Containment index over one axis pair (a,b) and one orthogonal edge pair (c,d) per rectangle.
+// For every coordinate pair a<b and every c it stores the minimum d over rectangles with
+// a<=a', b'<=b and c<=c'; so some rectangle lies inside [a,b]×[c,d] iff lowest(a,b,c) <= d.
+// This is the "min yt for each yb" table per (xi,xj), suffix-minimized over yb.
+// NearEdge / FarEdge additionally require a'==a / b'==b (the rectangle touches that side).
+struct ContainIndex {
+    enum Match { Inside, NearEdge, FarEdge };
+
+    int C = 0;
+    PairIndex pairs;
+    vector<int> table;   // [pair(a,b)][c], INT_MAX when no rectangle qualifies
+
+    ContainIndex(int A, int C_, const vector<array<int,4>> &items, Match match = Inside) : C(C_), pairs(A) {
+        table.assign(pairs.count * (size_t)C, INT_MAX);
+        for (const auto &it : items) {
+            int &slot = table[pairs(it[0], it[1]) * C + it[2]];
+            slot = min(slot, it[3]);
+        }
+        // Rectangles inside [a+1,b] or [a,b-1] are inside [a,b]; widths grow, so both are final.
+        // Touching the near side a only inherits from [a,b-1], touching the far side only from [a+1,b].
+        for (int w = 2; w < A; ++w)
+            for (int a = 0; a + w < A; ++a) {
+                int *dst = &table[pairs(a, a + w) * C];
+                const int *l = &table[pairs(a + 1, a + w) * C], *r = &table[pairs(a, a + w - 1) * C];
+                for (int c = 0; c < C; ++c) {
+                    if (match != NearEdge) dst[c] = min(dst[c], l[c]);
+                    if (match != FarEdge)  dst[c] = min(dst[c], r[c]);
+                }
+            }
+        for (size_t p = 0; p < pairs.count; ++p) {
+            int *row = &table[p * C];
+            for (int c = C - 2; c >= 0; --c) row[c] = min(row[c], row[c + 1]);
+        }
+    }
+
+    bool any(int a, int b, int c, int d) const { return table[pairs(a, b) * C + c] <= d; }
+};
+
+// Three-sided counts over the same (a,b) pair × c layout: the number (or total weight) of
+// rectangles with a<=a', b'<=b and c'>=c (AtLeast, on the near edge c') or d'<=c (AtMost, on
+// the far edge d').
+template <class V>
+struct SlabCount {
+    enum Side { AtLeast, AtMost };
+
+    int C = 0;
+    PairIndex pairs;
+    vector<V> table;   // [pair(a,b)][c]
+
+    SlabCount(int A, int C_, const vector<array<int,4>> &items, const vector<V> &weights, Side side) : C(C_), pairs(A) {
+        table.assign(pairs.count * (size_t)C, 0);
+        for (size_t i = 0; i < items.size(); ++i) {
+            const auto &it = items[i];
+            table[pairs(it[0], it[1]) * C + (side == AtLeast ? it[2] : it[3])] += weights[i];
+        }
+        // Inclusion-exclusion over the two sub-pairs; their common part is the pair (a+1,b-1)
+        for (int w = 2; w < A; ++w)
+            for (int a = 0; a + w < A; ++a) {
+                V *dst = &table[pairs(a, a + w) * C];
+                const V *l = &table[pairs(a + 1, a + w) * C], *r = &table[pairs(a, a + w - 1) * C];
+                const V *both = w > 2 ? &table[pairs(a + 1, a + w - 1) * C] : nullptr;
+                for (int c = 0; c < C; ++c) dst[c] += l[c] + r[c] - (both ? both[c] : 0);
+            }
+        for (size_t p = 0; p < pairs.count; ++p) {
+            V *row = &table[p * C];
+            if (side == AtLeast) for (int c = C - 2; c >= 0; --c) row[c] += row[c + 1];
+            else                 for (int c = 1; c < C; ++c)      row[c] += row[c - 1];
+        }
+    }
+
+    V at(int a, int b, int c) const { return table[pairs(a, b) * C + c]; }
+};
+
+// Precomputed lookups for the per-state scans of the DP; weight[rid] is the value of taking rid
+template <class V>
+struct RectIndex {
+    int X, Y;
+    ContainIndex inside;                 // (xl,xr) pairs × yb → min yt
+    ContainIndex leftEdge, rightEdge;    // same, restricted to xl==xi / xr==xj
+    ContainIndex bottomEdge, topEdge;    // (yb,yt) pairs × xl → min xr, restricted to yb==yk / yt==yl
+    vector<V> weight;
+    SlabCount<V> aboveYb, belowYt;       // (xl,xr) pairs × y: rectangles with yb >= yk / yt <= yl
+    SlabCount<V> rightOfXl, leftOfXr;    // (yb,yt) pairs × x: rectangles with xl >= xi / xr <= xj
+    unordered_map<uint64_t, int> exact;  // packed (xl,xr,yb,yt) → heaviest (then lowest) rect id with that box
+
+    static vector<array<int,4>> xyItems(const vector<RI> &RIv) {
+        vector<array<int,4>> items;
+        items.reserve(RIv.size());
+        for (const auto &q : RIv) items.push_back({q.xl, q.xr, q.yb, q.yt});
+        return items;
+    }
+    static vector<array<int,4>> yxItems(const vector<RI> &RIv) {
+        vector<array<int,4>> items;
+        items.reserve(RIv.size());
+        for (const auto &q : RIv) items.push_back({q.yb, q.yt, q.xl, q.xr});
+        return items;
+    }
+
+    RectIndex(int X_, int Y_, const vector<RI> &RIv, vector<V> weights)
+        : X(X_), Y(Y_),
+          inside(X_, Y_, xyItems(RIv)),
+          leftEdge(X_, Y_, xyItems(RIv), ContainIndex::NearEdge),
+          rightEdge(X_, Y_, xyItems(RIv), ContainIndex::FarEdge),
+          bottomEdge(Y_, X_, yxItems(RIv), ContainIndex::NearEdge),
+          topEdge(Y_, X_, yxItems(RIv), ContainIndex::FarEdge),
+          weight(move(weights)),
+          aboveYb(X_, Y_, xyItems(RIv), weight, SlabCount<V>::AtLeast),
+          belowYt(X_, Y_, xyItems(RIv), weight, SlabCount<V>::AtMost),
+          rightOfXl(Y_, X_, yxItems(RIv), weight, SlabCount<V>::AtLeast),
+          leftOfXr(Y_, X_, yxItems(RIv), weight, SlabCount<V>::AtMost) {
+        exact.reserve(RIv.size());
+        for (int rid = 0; rid < (int)RIv.size(); ++rid) {
+            auto [it, fresh] = exact.emplace(pack(RIv[rid].xl, RIv[rid].xr, RIv[rid].yb, RIv[rid].yt), rid);
+            if (!fresh && weight[rid] > weight[it->second]) it->second = rid;
+        }
+    }
+
+    uint64_t pack(int xi, int xj, int yk, int yl) const {
+        return (((uint64_t)xi * X + xj) * Y + yk) * Y + yl;
+    }
+    // Does any rectangle lie fully inside [xi,xj]×[yk,yl]?  O(1)
+    bool windowHasAnyRect(int xi, int xj, int yk, int yl) const { return inside.any(xi, xj, yk, yl); }
+    // Does a rectangle inside the window touch its left / right / bottom / top side?
+    bool touchesLeft(int xi, int xj, int yk, int yl) const { return leftEdge.any(xi, xj, yk, yl); }
+    bool touchesRight(int xi, int xj, int yk, int yl) const { return rightEdge.any(xi, xj, yk, yl); }
+    bool touchesBottom(int xi, int xj, int yk, int yl) const { return bottomEdge.any(yk, yl, xi, xj); }
+    bool touchesTop(int xi, int xj, int yk, int yl) const { return topEdge.any(yk, yl, xi, xj); }
+
+    // Cheap upper bound on the DP value: the number (weight) of rectangles inside the window,
+    // relaxed to four three-sided sums that each drop one of the window's sides. O(1)
+    V upperBound(int xi, int xj, int yk, int yl) const {
+        return min(min(aboveYb.at(xi, xj, yk), belowYt.at(xi, xj, yl)),
+                   min(rightOfXl.at(yk, yl, xi), leftOfXr.at(yk, yl, xj)));
+    }
+
+    // Shrinks a non-empty window to the bounding box of the rectangles inside it. The contained
+    // set (and therefore the DP value) does not change, so equivalent windows share one state.
+    void tighten(int &xi, int &xj, int &yk, int &yl) const {
+        while (!touchesLeft(xi, xj, yk, yl)) ++xi;
+        while (!touchesRight(xi, xj, yk, yl)) --xj;
+        while (!touchesBottom(xi, xj, yk, yl)) ++yk;
+        while (!touchesTop(xi, xj, yk, yl)) --yl;
+    }
+
+    // Id of a rectangle exactly equal to the window, or -1
+    int exactMatch(int xi, int xj, int yk, int yl) const {
+        auto it = exact.find(pack(xi, xj, yk, yl));
+        return it == exact.end() ? -1 : it->second;
+    }
+};
+
+// Dense memo: one slot per window with xi<xj and yk<yl. Both coordinate pairs are
+// triangular-packed, so the table holds X(X-1)/2 * Y(Y-1)/2 entries instead of X*X*Y*Y.
+// Entries are AnswerCodec words: 4 bytes per state on grids of up to 256 coordinates.
+template <class V, class C>
+struct DenseMemo {
+    using Value = V;
+    using Answer = guillotine_solver::Answer<V>;
+    using Codec = AnswerCodec<V, C>;
+    using Word = typename Codec::Word;
+    static constexpr bool keepsChoice = true;
+
+    int X = 0, Y = 0;
+    PairIndex px{0}, py{0};
+    vector<Word> table;          // Codec::empty() marks a state that has not been solved yet
+
+    static size_t bytesFor(int X, int Y) { return PairIndex::pairCount(X) * PairIndex::pairCount(Y) * sizeof(Word); }
+
+    DenseMemo() = default;
+    DenseMemo(int X_, int Y_) { reset(X_, Y_); }
+
+    // Clears the table for an X×Y grid, keeping the allocation when it is large enough
+    void reset(int X_, int Y_) {
+        X = X_; Y = Y_; px = PairIndex(X_); py = PairIndex(Y_);
+        table.assign(px.count * py.count, Codec::empty());
+    }
+
+    size_t index(int xi, int xj, int yk, int yl) const { return px(xi, xj) * py.count + py(yk, yl); }
+    bool find(int xi, int xj, int yk, int yl, Answer &out) const {
+        const Word &w = table[index(xi, xj, yk, yl)];
+        if (Codec::isEmpty(w)) return false;
+        out = Codec::unpack(w);
+        return true;
+    }
+    void store(int xi, int xj, int yk, int yl, const Answer &a) { table[index(xi, xj, yk, yl)] = Codec::pack(a); }
+    void release() { vector<Word>().swap(table); }
+};
+
+// Hash memo: fallback for instances whose dense table would not fit in memory, keyed by the
+// packed window
+template <class V, class C>
+struct HashMemo {
+    using Value = V;
+    using Answer = guillotine_solver::Answer<V>;
+    using Keys = StateKey<C>;
+    using Codec = AnswerCodec<V, C>;
+    using Map = unordered_map<typename Keys::Word, typename Codec::Word, typename Keys::Hash>;
+    static constexpr bool keepsChoice = true;
+
+    Map memo;
+
+    void reset() { memo.clear(); }   // keeps the bucket array
+    bool find(int xi, int xj, int yk, int yl, Answer &out) const {
+        auto it = memo.find(Keys::pack(xi, xj, yk, yl));
+        if (it == memo.end()) return false;
+        out = Codec::unpack(it->second);
+        return true;
+    }
+    void store(int xi, int xj, int yk, int yl, const Answer &a) { memo[Keys::pack(xi, xj, yk, yl)] = Codec::pack(a); }
+    void release() { Map().swap(memo); }
+};
+
+// Memory-capped memo (--memory-cap): a fixed table of packed entries, the four window
+// coordinates as C and the value; with uint16 coordinates 12 bytes for counts and 16 for
+// weights, 8 and 16 with uint8. The choice is not kept; recon recomputes it along the solution
+// path. The table is 4-way set-associative and every set is kept in most-recently-used order.
+// A full set drops its smallest window, the cheapest to solve again, and the least recently
+// used one among equals; keeping the large windows delays the blow-up of recomputation when the
+// cap is below the working set. A dropped window is solved again when it is needed: the answer
+// stays exact and the table never grows.
+template <class V, class C>
+struct BoundedMemo {
+    using Value = V;
+    using Answer = guillotine_solver::Answer<V>;
+    static constexpr bool keepsChoice = false;
+    static constexpr int WAYS = 4;
+
+    struct Entry { C xi, xj, yk, yl; V val; };   // xi == xj marks a free slot
+
+    vector<Entry> table;
+    int setBits = 0;
+    uint64_t evictions = 0;     // windows dropped from a full set
+
+    // Empties the table and sizes it to the largest power-of-two number of sets within capBytes
+    void reset(size_t capBytes) {
+        setBits = 0;
+        while (((size_t)2 << setBits) * WAYS * sizeof(Entry) <= capBytes) ++setBits;
+        table.assign(((size_t)1 << setBits) * WAYS, Entry{});
+        evictions = 0;
+    }
+    void release() { vector<Entry>().swap(table); }
+
+    Entry *setOf(int xi, int xj, int yk, int yl) {
+        uint64_t k = ((uint64_t)xi << 48) ^ ((uint64_t)xj << 32) ^ ((uint64_t)yk << 16) ^ (uint64_t)yl;
+        size_t set = setBits ? (size_t)((k * 0x9E3779B97F4A7C15ull) >> (64 - setBits)) : 0;
+        return &table[set * WAYS];
+    }
+    static bool holds(const Entry &e, int xi, int xj, int yk, int yl) {
+        return e.xi == (C)xi && e.xj == (C)xj && e.yk == (C)yk && e.yl == (C)yl;
+    }
+
+    // A hit moves the window to the front of its set; out.ch is left empty
+    bool find(int xi, int xj, int yk, int yl, Answer &out) {
+        Entry *set = setOf(xi, xj, yk, yl);
+        for (int w = 0; w < WAYS; ++w) {
+            if (!holds(set[w], xi, xj, yk, yl)) continue;
+            Entry e = set[w];
+            memmove(set + 1, set, w * sizeof(Entry));
+            set[0] = e;
+            out = Answer{e.val, {}};
+            return true;
+        }
+        return false;
+    }
+    // Inserts at the front of the set, over the same window, else the first free slot, else the
+    // smallest (then least recently used) window
+    void store(int xi, int xj, int yk, int yl, const Answer &a) {
+        Entry *set = setOf(xi, xj, yk, yl);
+        int w = 0;
+        while (w < WAYS - 1 && set[w].xi != set[w].xj && !holds(set[w], xi, xj, yk, yl)) ++w;
+        if (set[w].xi != set[w].xj && !holds(set[w], xi, xj, yk, yl)) {
+            ++evictions;
+            auto span = [](const Entry &e) { return (e.xj - e.xi) + (e.yl - e.yk); };
+            for (int v = WAYS - 2; v >= 0; --v) if (span(set[v]) < span(set[w])) w = v;
+        }
+        memmove(set + 1, set, w * sizeof(Entry));
+        set[0] = Entry{(C)xi, (C)xj, (C)yk, (C)yl, a.val};
+    }
+};
+static_assert(sizeof(BoundedMemo<int, uint16_t>::Entry) == 12, "BoundedMemo entries must stay packed");
+
+// Largest dense table we are willing to allocate before falling back to the hash memo
+const size_t DENSE_MEMO_MAX_BYTES = size_t(2) << 30;   // 2 GiB
+
+// Time limit and progress lines for one instance, shared by all of its blocks
+struct RunControl {
+    TimeBudget budget;
+    Progress progress;
+    atomic<uint64_t> states{0};     // DP states solved so far
+    atomic<double> finished{0.0};   // value of the blocks solved so far
+    atomic<bool> timedOut{false};
+    PhaseTimes *phases = nullptr;   // per-phase timings (phase_times.h), if wanted
+    Counters counters;              // event counts of all blocks (counters.h)
+
+    RunControl(double timeLimit, double progressEvery) : budget(timeLimit), progress(budget, progressEvery) {}
+};
+
+template <class Memo>
+struct GuillotineDP {
+    using V = typename Memo::Value;
+    using Answer = typename Memo::Answer;
+
+    const RectIndex<V> &idx;
+    Memo &memo;
+    bool prune;   // only cut at edges of contained rectangles and memoize tightened windows
+    bool bound;   // skip cuts (or second halves) whose upper bound cannot beat the best so far
+    RunControl *run;
+    atomic<bool> stopped{false};   // past the deadline: finish greedily
+    unsigned ticks = 0;
+    uint64_t solvedStates = 0;     // top-down states not yet added to run->states
+    Tally tally;                   // counts of the single-threaded parts, added to run->counters at the end
+
+    GuillotineDP(const RectIndex<V> &index, Memo &m, bool pruneCuts, bool useBound, RunControl *control = nullptr)
+        : idx(index), memo(m), prune(pruneCuts), bound(useBound), run(control) {}
+    ~GuillotineDP() { if (run) run->counters.add(tally); }
+    GuillotineDP(const GuillotineDP &) = delete;
+    GuillotineDP &operator=(const GuillotineDP &) = delete;
+
+    // Top-down clock check, every 64 calls
+    bool expired() {
+        if (stopped.load(memory_order_relaxed)) return true;
+        if (!run || !run->budget.limited() || (++ticks & 63) != 0 || !run->budget.expired()) return false;
+        stopped = true;
+        run->timedOut = true;
+        return true;
+    }
+
+    bool hasAnyRect(int xi, int xj, int yk, int yl, Tally &t) const {
+        t.add(CTR_WINDOW_QUERIES);
+        return idx.windowHasAnyRect(xi, xj, yk, yl);
+    }
+    Answer store(int xi, int xj, int yk, int yl, const Answer &a, Tally &t) {
+        t.add(CTR_DP_STATES);
+        memo.store(xi, xj, yk, yl, a);
+        return a;
+    }
+
+    void countStates(uint64_t k) {
+        if (!run) return;
+        run->states += k;
+        run->progress.report(run->finished, run->states, "states");
+    }
+
+    // One DP transition: best of the leaf option and every guillotine cut of the window.
+    // `sub` returns the answer of a strictly smaller window (a recursive call top-down,
+    // a table read bottom-up), so both engines share the exact same recurrence.
+    //
+    // With pruning the window is expected to be tight. A cut at c keeps the rectangles inside
+    // either half; sliding c left to the nearest right edge of a left-half rectangle (or right to
+    // the nearest left edge of a right-half one) keeps that set or enlarges it, so only cuts at
+    // such edges are tried. The optimum is unchanged.
+    //
+    // With bounding, a cut is skipped when upperBound(first) + upperBound(second) cannot beat
+    // best.val, and the second half is not solved when first.val + upperBound(second) cannot.
+    // The loop stops as soon as best.val reaches the window's own bound. Only cuts that cannot
+    // improve are skipped, so best stays exact and can be memoized.
+    //
+    // Once the DP is stopped the loop returns as soon as it has any choice. t is the calling
+    // thread's tally.
+    template <class Sub>
+    Answer evaluate(int xi, int xj, int yk, int yl, Sub &&sub, Tally &t) const {
+        // If no rectangle lies fully inside this window, value is 0 (no point cutting further)
+        if (!hasAnyRect(xi,xj,yk,yl, t)) return Answer{0,{}};
+
+        Answer best{0,{}};
+
+        // Leaf option: if the window exactly equals some rectangle, we can take it and stop.
+        if (int rid = idx.exactMatch(xi, xj, yk, yl); rid >= 0)
+            best = {idx.weight[rid], {1, rid}};   // still try cuts; a split might yield more in total
+
+        const V cap = bound ? idx.upperBound(xi, xj, yk, yl) : numeric_limits<V>::max();
+        if (best.val >= cap) return best;
+
+        // Try ALL vertical cuts xi < c < xj (guillotine cut slices across; rectangles cut by it are discarded)
+        for (int c = xi+1; c <= xj-1; ++c) {
+            if (prune && !idx.touchesRight(xi, c, yk, yl) && !idx.touchesLeft(c, xj, yk, yl)) continue;
+            t.add(CTR_CUTS_TRIED);
+            if (best.ch.type != 0 && stopped.load(memory_order_relaxed)) return best;
+            if (bound && idx.upperBound(xi, c, yk, yl) + idx.upperBound(c, xj, yk, yl) <= best.val) continue;
+            Answer L  = sub(xi, c, yk, yl);
+            if (bound && L.val + idx.upperBound(c, xj, yk, yl) <= best.val) continue;
+            Answer Rw = sub(c,  xj, yk, yl);
+            V v = L.val + Rw.val;
+            if (v > best.val) best = {v, {2, c}};
+            if (best.val >= cap) return best;
+        }
+
+        // Try ALL horizontal cuts yk < c < yl
+        for (int c = yk+1; c <= yl-1; ++c) {
+            if (prune && !idx.touchesTop(xi, xj, yk, c) && !idx.touchesBottom(xi, xj, c, yl)) continue;
+            t.add(CTR_CUTS_TRIED);
+            if (best.ch.type != 0 && stopped.load(memory_order_relaxed)) return best;
+            if (bound && idx.upperBound(xi, xj, yk, c) + idx.upperBound(xi, xj, c, yl) <= best.val) continue;
+            Answer B = sub(xi, xj, yk, c);
+            if (bound && B.val + idx.upperBound(xi, xj, c, yl) <= best.val) continue;
+            Answer T = sub(xi, xj, c,  yl);
+            V v = B.val + T.val;
+            if (v > best.val) best = {v, {3, c}};
+            if (best.val >= cap) return best;
+        }
+
+        return best;
+    }
+
+    // Bottom-up transition with pruning: a window that is not tight has the value (and the
+    // choice) of the window one step smaller on a loose side, which is already in the table.
+    template <class Sub>
+    Answer evaluateTight(int xi, int xj, int yk, int yl, Sub &&sub, Tally &t) const {
+        if (!hasAnyRect(xi,xj,yk,yl, t)) return Answer{0,{}};
+        if (!idx.touchesLeft(xi,xj,yk,yl))   return sub(xi+1, xj, yk, yl);
+        if (!idx.touchesRight(xi,xj,yk,yl))  return sub(xi, xj-1, yk, yl);
+        if (!idx.touchesBottom(xi,xj,yk,yl)) return sub(xi, xj, yk+1, yl);
+        if (!idx.touchesTop(xi,xj,yk,yl))    return sub(xi, xj, yk, yl-1);
+        return evaluate(xi, xj, yk, yl, sub, t);
+    }
+
+    // Unpruned transition over a filled dense table of packed counts: the answer and choice of
+    // evaluate(), with each direction's cuts max-reduced by maxPairSum (cut_kernel.h) instead of
+    // the branchy loop. Vertical cuts come first and a horizontal one must beat them, so the first
+    // strictly better cut wins as before; the bounds only skip cuts that cannot win. For
+    // c = xi+1 .. xj-1, left / right hold the table offsets px(xi,c) * py.count and
+    // px(c,xj) * py.count; ramp is 0, 1, 2, ... and yOff[c] = py.off[c] - c.
+    template <class Index>
+    Answer evaluateAll(int xi, int xj, int yk, int yl, const Index *left, const Index *right, const Index *ramp,
+                       const Index *yOff, Tally &t) const {
+        if (!hasAnyRect(xi,xj,yk,yl, t)) return Answer{0,{}};
+
+        Answer best{0,{}};
+        if (int rid = idx.exactMatch(xi, xj, yk, yl); rid >= 0) best = {idx.weight[rid], {1, rid}};
+        t.add(CTR_CUTS_TRIED, (uint64_t)((xj - xi - 1) + (yl - yk - 1)));
+
+        constexpr int shift = Memo::Codec::VALUE_SHIFT;
+        const auto *cell = memo.table.data() + memo.py(yk, yl);
+        if (CutMax v = maxPairSum(cell, left, cell, right, xj - xi - 1, shift); v.val > best.val)
+            best = {(V)v.val, {2, xi + 1 + v.at}};
+
+        // Bottom halves py(yk,c) = off[yk] + i are contiguous, top halves py(c,yl) = yOff[c] + yl - 1
+        const auto *row = memo.table.data() + memo.px(xi, xj) * memo.py.count;
+        if (CutMax h = maxPairSum(row + memo.py.off[yk], ramp, row + (yl - 1), yOff + (yk + 1), yl - yk - 1, shift);
+            h.val > best.val)
+            best = {(V)h.val, {3, yk + 1 + h.at}};
+        return best;
+    }
+
+    // Top-down engine: memoized recursion from the requested window
+    Answer solve(int xi, int xj, int yk, int yl) {
+        if (xi>=xj || yk>=yl) return Answer{0,{}};
+        if (prune) {
+            if (!hasAnyRect(xi,xj,yk,yl, tally)) return Answer{0,{}};
+            idx.tighten(xi, xj, yk, yl);
+        }
+
+        if (Answer a; memo.find(xi,xj,yk,yl, a)) { tally.add(CTR_MEMO_HITS); return a; }
+        tally.add(CTR_MEMO_MISSES);
+        if (expired()) return greedy(xi, xj, yk, yl);
+
+        Answer best = evaluate(xi, xj, yk, yl, [this](int a, int b, int c, int d) { return solve(a, b, c, d); }, tally);
+        if ((++solvedStates & 4095) == 0) countStates(4096);
+        return store(xi,xj,yk,yl, best, tally);
+    }
+
+    // Greedy completion of an unsolved window after the deadline, stored like a DP answer so that
+    // recon can follow it (solved windows keep their exact answer). A window equal to a
+    // rectangle takes it; otherwise the cut is at the smallest right edge inside the window,
+    // else the smallest top edge, else the largest left or bottom edge. One of them exists
+    // unless the window is a rectangle, and every cut keeps a whole rectangle on one side.
+    Answer greedy(int xi, int xj, int yk, int yl) {
+        if (xi>=xj || yk>=yl || !hasAnyRect(xi,xj,yk,yl, tally)) return Answer{0,{}};
+        if (prune) idx.tighten(xi, xj, yk, yl);
+        if (Answer a; memo.find(xi,xj,yk,yl, a)) return a;
+        if (int rid = idx.exactMatch(xi, xj, yk, yl); rid >= 0) return store(xi,xj,yk,yl, Answer{idx.weight[rid], {1, rid}}, tally);
+
+        int type = 0, cut = -1;
+        for (int c = xi+1; c < xj && cut < 0; ++c) if (idx.touchesRight(xi, c, yk, yl)) { type = 2; cut = c; }
+        for (int c = yk+1; c < yl && cut < 0; ++c) if (idx.touchesTop(xi, xj, yk, c)) { type = 3; cut = c; }
+        for (int c = xj-1; c > xi && cut < 0; --c) if (idx.touchesLeft(c, xj, yk, yl)) { type = 2; cut = c; }
+        for (int c = yl-1; c > yk && cut < 0; --c) if (idx.touchesBottom(xi, xj, c, yl)) { type = 3; cut = c; }
+        if (cut < 0) return Answer{0,{}};   // not reached: then the window is a rectangle
+
+        V v = type == 2 ? greedy(xi, cut, yk, yl).val + greedy(cut, xj, yk, yl).val
+                        : greedy(xi, xj, yk, cut).val + greedy(xi, xj, cut, yl).val;
+        return store(xi,xj,yk,yl, Answer{v, {type, cut}}, tally);
+    }
+
+    // Bottom-up engine (dense memo only): fills every window in order of increasing
+    // compressed width+height. Each cut produces two windows of strictly smaller size, so
+    // all windows of one wavefront are independent and are split across `threads` workers.
+    // The workers start once per solve and meet at a barrier between wavefronts; worker 0
+    // lists the next wavefront's rows while the others wait.
+    void solveBottomUp(int threads) {
+        const int X = memo.X, Y = memo.Y;
+        auto lookup = [this](int xi, int xj, int yk, int yl) { Answer a; memo.find(xi, xj, yk, yl, a); return a; };
+        vector<Tally> tallies(max(threads, 1));
+
+        // Unpruned counts on packed words go through the cut kernel (evaluateAll)
+        using Word = typename Memo::Word;
+        using Index = conditional_t<sizeof(Word) == 4, int32_t, int64_t>;
+        constexpr bool packed = is_integral_v<Word>;
+        const bool kernel = packed && !prune;
+        vector<Index> ramp, yOff;
+        vector<vector<Index>> lefts, rights;   // per worker, for the row's (xi, xj)
+        if (kernel) {
+            ramp.resize(Y);
+            yOff.resize(Y);
+            for (int y = 0; y < Y; ++y) { ramp[y] = (Index)y; yOff[y] = (Index)(memo.py.off[y] - y); }
+            lefts.assign(tallies.size(), vector<Index>(X));
+            rights.assign(tallies.size(), vector<Index>(X));
+        }
+
+        vector<pair<int,int>> rows;   // (width, xi) work items of the current wavefront
+        atomic<size_t> next{0};
+        auto solveRow = [&](size_t t, int s, int worker) {
+            const int w = rows[t].first, xi = rows[t].second, xj = xi + w, h = s - w;
+            if (stopped.load(memory_order_relaxed)) return;
+            if (run && run->budget.expired()) { stopped = true; run->timedOut = true; return; }
+            Tally &tl = tallies[worker];
+            if constexpr (packed) if (kernel) {
+                Index *left = lefts[worker].data(), *right = rights[worker].data();
+                for (int c = xi + 1; c < xj; ++c) {
+                    left[c - xi - 1] = (Index)(memo.px(xi, c) * memo.py.count);
+                    right[c - xi - 1] = (Index)(memo.px(c, xj) * memo.py.count);
+                }
+                for (int yk = 0; yk + h < Y; ++yk)
+                    memo.store(xi, xj, yk, yk + h, evaluateAll(xi, xj, yk, yk + h, left, right, ramp.data(), yOff.data(), tl));
+                tl.add(CTR_DP_STATES, (uint64_t)max(0, Y - h));
+                return;
+            }
+            for (int yk = 0; yk + h < Y; ++yk) {
+                const int yl = yk + h;
+                memo.store(xi, xj, yk, yl, prune ? evaluateTight(xi, xj, yk, yl, lookup, tl)
+                                                 : evaluate(xi, xj, yk, yl, lookup, tl));
+            }
+            tl.add(CTR_DP_STATES, (uint64_t)max(0, Y - h));
+        };
+
+        // Past the deadline the remaining windows are left unsolved for greedy(). `stopped` is
+        // only set while rows are solved, so every worker sees the same value at the loop test.
+        Barrier barrier((int)tallies.size());
+        runWorkers((int)tallies.size(), [&](int worker) {
+            for (int s = 2; s <= (X-1) + (Y-1) && !stopped; ++s) {
+                if (worker == 0) {
+                    rows.clear();
+                    for (int w = max(1, s - (Y-1)); w <= min(X-1, s-1); ++w)
+                        for (int xi = 0; xi + w < X; ++xi) rows.push_back({w, xi});
+                    next.store(0, memory_order_relaxed);
+                }
+                barrier.wait();
+                for (size_t t; (t = next.fetch_add(1, memory_order_relaxed)) < rows.size(); ) solveRow(t, s, worker);
+                barrier.wait();
+                if (worker == 0) {
+                    uint64_t windows = 0;
+                    for (const auto &r : rows) windows += max(0, Y - (s - r.first));
+                    countStates(windows);
+                }
+            }
+        });
+        if (run) for (const Tally &tl : tallies) run->counters.add(tl);
+    }
+
+    // Reconstruct chosen rectangles. A memo without choices has the transition evaluated again
+    // on every window of the path, over (possibly recomputed) exact sub-values.
+    void recon(int xi, int xj, int yk, int yl, vector<int> &chosen) {
+        if (xi>=xj || yk>=yl) return;
+        if (prune) {
+            if (!hasAnyRect(xi,xj,yk,yl, tally)) return;
+            idx.tighten(xi, xj, yk, yl);
+        }
+        Answer A;
+        if constexpr (Memo::keepsChoice) {
+            if (!memo.find(xi,xj,yk,yl, A)) return;
+        } else {
+            A = evaluate(xi, xj, yk, yl, [this](int a, int b, int c, int d) { return solve(a, b, c, d); }, tally);
+        }
+        if (A.val==0) return;
+        if (A.ch.type==1) { chosen.push_back(A.ch.param >= 0 ? A.ch.param : idx.exactMatch(xi,xj,yk,yl)); return; }
+        if (A.ch.type==2) { int c=A.ch.param; recon(xi,c,yk,yl,chosen); recon(c,xj,yk,yl,chosen); return; }
+        if (A.ch.type==3) { int c=A.ch.param; recon(xi,xj,yk,c,chosen); recon(xi,xj,c,yl,chosen); return; }
+    }
+};
+
+// Solver settings shared by every independent block
+struct Options {
+    string memoMode = "auto";     // auto | dense | hash | bounded
+    string engine = "auto";       // auto | topdown | bottomup
+    bool prune = true;            // candidate-cut pruning + window tightening
+    bool bound = true;            // upper-bound (branch-and-bound) pruning of cuts
+    bool decompose = true;        // split at free cuts first
+    bool reduce = true;           // drop rectangles that contain another one
+    double timeLimit = -1;        // seconds per instance, < 0 = none
+    double progressEvery = 0;     // seconds between progress lines on stderr, 0 = off
+    int threads = 0;              // 0 = one per hardware thread
+    bool timePhases = false;      // fill SolveStats::phaseSeconds
+    size_t memoryCap = 0;         // bytes for the memo tables of all running blocks, 0 = no cap
+};
+
+// Per-thread buffers kept across blocks and instances (--batch), so repeated solves reuse
+// the memo and conflict-graph storage instead of reallocating it
+struct Box { double x1, y1, x2, y2; };
+template <class V, class C> struct Memos {
+    DenseMemo<V, C> dense;
+    HashMemo<V, C> hash;
+    BoundedMemo<V, C> bounded;
+    void release() { dense.release(); hash.release(); bounded.release(); }
+};
+struct Workspace {
+    // One set per value type (counts, weights) and coordinate width
+    tuple<Memos<int, uint8_t>, Memos<int, uint16_t>, Memos<int, uint32_t>,
+          Memos<double, uint8_t>, Memos<double, uint16_t>, Memos<double, uint32_t>> memoSets;
+    ConflictGraphBuilder builder;
+    ConflictGraph adj;
+    vector<Box> boxes;
+
+    template <class V, class C> Memos<V, C> &memos() { return get<Memos<V, C>>(memoSets); }
+    void releaseMemos() { apply([](auto &... m) { (m.release(), ...); }, memoSets); }
+};
+
+// A line crossing no rectangle interior is a free cut: every guillotine-separable set splits
+// along it into guillotine-separable sets on both sides, and any two such sets recombine. So
+// the optimum is the sum over the blocks left after cutting at all free lines, alternately in
+// x and y until no block splits further. Each block gets its own, much smaller, compressed grid.
+inline vector<vector<int>> splitAtFreeCuts(const vector<Rect> &R, vector<int> ids) {
+    vector<vector<int>> blocks, pending{move(ids)};
+
+    // Splits ids at free lines of one axis; returns false when there is none
+    auto split = [&](vector<int> &ids, bool vertical, vector<vector<int>> &out) {
+        auto lo = [&](int id) { return vertical ? R[id].xl : R[id].yb; };
+        auto hi = [&](int id) { return vertical ? R[id].xr : R[id].yt; };
+        sort(ids.begin(), ids.end(), [&](int a, int b) { return lo(a) != lo(b) ? lo(a) < lo(b) : a < b; });
+        size_t first = out.size();
+        long long reach = LLONG_MIN;
+        for (int id : ids) {
+            if (lo(id) >= reach) out.emplace_back();   // nothing so far crosses lo(id)
+            out.back().push_back(id);
+            reach = max(reach, hi(id));
+        }
+        if (out.size() - first > 1) return true;
+        out.pop_back();
+        return false;
+    };
+
+    while (!pending.empty()) {
+        vector<int> ids = move(pending.back());
+        pending.pop_back();
+        vector<vector<int>> parts;
+        if (ids.size() > 1 && (split(ids, true, parts) || split(ids, false, parts)))
+            for (auto &p : parts) pending.push_back(move(p));
+        else blocks.push_back(move(ids));
+    }
+    return blocks;
+}
+
+// Picks the memo for one block's X×Y grid (coordinates of type C) and runs the DP on it; chosen
+// receives block-local rectangle ids
+template <class V, class C>
+void solveGrid(const RectIndex<V> &index, const Options &opts, int threads, Workspace &ws, RunControl &run,
+               PhaseTimer &timer, vector<int> &chosen) {
+    const int X = index.X, Y = index.Y;
+    // Dense table when it fits, hash memo otherwise; reconstruction reads from the same table
+    // The bottom-up engine fills the whole table, so it runs whenever the dense memo is used
+    // and the top-down engine was not requested explicitly.
+    // Under a memory cap a dense table that does not fit gives way to the bounded memo, which
+    // then holds the only memo storage of this workspace.
+    const size_t denseBytes = DenseMemo<V, C>::bytesFor(X, Y);
+    const size_t cap = opts.memoryCap ? opts.memoryCap : DENSE_MEMO_MAX_BYTES;
+    bool useBounded = (opts.memoMode == "bounded" || (opts.memoMode == "auto" && opts.memoryCap && denseBytes > cap))
+                      && opts.engine != "bottomup";
+    bool useDense = !useBounded && (opts.memoMode == "dense" || opts.engine == "bottomup" ||
+                                    (opts.memoMode == "auto" && denseBytes <= cap));
+    bool bottomUp = useDense && opts.engine != "topdown";
+    if (opts.memoryCap) ws.releaseMemos();
+    Memos<V, C> &memos = ws.memos<V, C>();
+    if (useBounded) {
+        // No bigger than twice the block's windows, so a small block takes little memory
+        const size_t windows = PairIndex::pairCount(X) * PairIndex::pairCount(Y);
+        memos.bounded.reset(min(cap, 2 * windows * sizeof(typename BoundedMemo<V, C>::Entry)));
+        GuillotineDP<BoundedMemo<V, C>> dp(index, memos.bounded, opts.prune, opts.bound, &run);
+        timer.next(PHASE_SEARCH);
+        dp.solve(0, X-1, 0, Y-1);
+        timer.next(PHASE_RECONSTRUCT);
+        dp.recon(0, X-1, 0, Y-1, chosen);
+        run.counters.add(CTR_MEMO_EVICTIONS, memos.bounded.evictions);
+    } else if (useDense) {
+        memos.dense.reset(X, Y);
+        GuillotineDP<DenseMemo<V, C>> dp(index, memos.dense, opts.prune, opts.bound, &run);
+        timer.next(PHASE_SEARCH);
+        if (bottomUp) dp.solveBottomUp(threads);
+        dp.solve(0, X-1, 0, Y-1);
+        timer.next(PHASE_RECONSTRUCT);
+        dp.recon(0, X-1, 0, Y-1, chosen);
+    } else {
+        memos.hash.reset();
+        GuillotineDP<HashMemo<V, C>> dp(index, memos.hash, opts.prune, opts.bound, &run);
+        timer.next(PHASE_SEARCH);
+        dp.solve(0, X-1, 0, Y-1);
+        timer.next(PHASE_RECONSTRUCT);
+        dp.recon(0, X-1, 0, Y-1, chosen);
+    }
+}
+
+// Solves the guillotine DP over the rectangles `ids` of R, maximizing the count (V = int) or
+// the total weight (V = double); returns the chosen ids
+template <class V>
+vector<int> solveBlock(const vector<Rect> &R, const vector<int> &ids, const Options &opts, int threads, Workspace &ws,
+                       RunControl &run) {
+    const int n = (int)ids.size();
+    PhaseTimer timer(run.phases, PHASE_COMPRESS);
+
+    // ---------- Coordinate compression ----------
+    vector<long long> xs, ys;
+    xs.reserve(2*n); ys.reserve(2*n);
+    for (int id : ids) { const Rect &r = R[id]; xs.push_back(r.xl); xs.push_back(r.xr); ys.push_back(r.yb); ys.push_back(r.yt); }
+    sort(xs.begin(), xs.end()); xs.erase(unique(xs.begin(), xs.end()), xs.end());
+    sort(ys.begin(), ys.end()); ys.erase(unique(ys.begin(), ys.end()), ys.end());
+    const int X = (int)xs.size(), Y = (int)ys.size();   // Stores the number of unique x and y coordinates
+
+    vector<RI> RIv(n);
+    for (int i=0;i<n;++i){
+        RIv[i].xl = (int)(lower_bound(xs.begin(), xs.end(), R[ids[i]].xl) - xs.begin());
+        RIv[i].xr = (int)(lower_bound(xs.begin(), xs.end(), R[ids[i]].xr) - xs.begin());
+        RIv[i].yb = (int)(lower_bound(ys.begin(), ys.end(), R[ids[i]].yb) - ys.begin());
+        RIv[i].yt = (int)(lower_bound(ys.begin(), ys.end(), R[ids[i]].yt) - ys.begin());
+    }
+
+    // ---------- Solve on the block's bounding window ----------
+    // The memo encodings take the narrowest coordinate type of the block's grid
+    vector<V> weights(n);
+    for (int i = 0; i < n; ++i) weights[i] = (V)R[ids[i]].w;
+    RectIndex<V> index(X, Y, RIv, move(weights));
+    timer.next(PHASE_INIT);
+    vector<int> chosen;
+    if (max(X, Y) <= 256) solveGrid<V, uint8_t>(index, opts, threads, ws, run, timer, chosen);
+    else if (max(X, Y) <= 65536) solveGrid<V, uint16_t>(index, opts, threads, ws, run, timer, chosen);
+    else solveGrid<V, uint32_t>(index, opts, threads, ws, run, timer, chosen);
+
+    double value = 0, seen = run.finished;
+    for (int &rid : chosen) { rid = ids[rid]; value += R[rid].w; }
+    while (!run.finished.compare_exchange_weak(seen, seen + value)) {}
+    return chosen;
+}
+
+// Solves one instance; ws holds one workspace per thread. Returns the chosen rectangle ids.
+// Blocks that run past run's deadline are completed greedily (run.timedOut is then set).
+inline vector<int> solveInstance(const vector<Rect> &R, const Options &opts, int threads, vector<Workspace> &ws,
+                          RunControl &run) {
+    // Weights other than 1 switch the DP to weight sums; rectangles of weight <= 0 never help
+    PhaseTimer timer(run.phases, PHASE_GRAPH);
+    const int n = (int)R.size();
+    bool weighted = false;
+    vector<int> kept;
+    for (int i = 0; i < n; ++i) {
+        weighted |= R[i].w != 1;
+        if (R[i].w > 0) kept.push_back(i);
+    }
+
+    // ---------- Drop rectangles containing another one (reduce.h) ----------
+    // A contained rectangle of at least the same weight can replace its container in any
+    // guillotine-separable set
+    if (opts.reduce) {
+        Workspace &w0 = ws[0];
+        const int m = (int)kept.size();
+        vector<double> weights(weighted ? m : 0);
+        w0.boxes.resize(m);
+        for (int i = 0; i < m; ++i) {
+            const Rect &r = R[kept[i]];
+            w0.boxes[i] = {(double)r.xl, (double)r.yb, (double)r.xr, (double)r.yt};
+            if (weighted) weights[i] = r.w;
+        }
+        w0.builder.build(w0.boxes, w0.adj);
+        run.counters.add(CTR_CONFLICT_EDGES, w0.adj.edgeCount());
+        vector<int> reduced = containedRectangleReduction(w0.boxes, w0.adj, weights).kept;
+        for (int &i : reduced) i = kept[i];
+        kept = move(reduced);
+    }
+
+    // ---------- Split at free cuts, solve the blocks independently ----------
+    vector<vector<int>> blocks;
+    if (opts.decompose) blocks = splitAtFreeCuts(R, move(kept));
+    else blocks.push_back(move(kept));
+
+    // Single rectangles are taken directly; the others are solved largest first so that big
+    // blocks start early. With one block left, its bottom-up engine gets all the threads.
+    vector<int> chosen;
+    vector<vector<int>> work;
+    for (auto &blk : blocks) {
+        if (blk.size() == 1) chosen.push_back(blk[0]);
+        else work.push_back(move(blk));
+    }
+    for (int id : chosen) run.finished = run.finished + R[id].w;
+    stable_sort(work.begin(), work.end(), [](const vector<int> &a, const vector<int> &b) { return a.size() > b.size(); });
+    timer.stop();
+
+    // A memory cap is shared by the blocks that run at the same time
+    vector<vector<int>> picked(work.size());
+    const int inner = work.size() == 1 ? threads : 1;
+    Options blockOpts = opts;
+    if (!work.empty()) blockOpts.memoryCap /= min(work.size(), (size_t)max(threads, 1));
+    parallelForWorker(work.size(), threads, [&](size_t w, int worker) {
+        picked[w] = weighted ? solveBlock<double>(R, work[w], blockOpts, inner, ws[worker], run)
+                             : solveBlock<int>(R, work[w], blockOpts, inner, ws[worker], run);
+    });
+    PhaseTimer merge(run.phases, PHASE_RECONSTRUCT);
+    for (auto &p : picked) chosen.insert(chosen.end(), p.begin(), p.end());
+    return chosen;
+}
+
+} // namespace guillotine_solver
+
+// Solves inst; ws (one workspace per thread, grown as needed) keeps the memos and buffers across
+// calls, as --batch does. Without it a temporary set is used.
+inline Solution solve_guillotine(const Instance &inst, const guillotine_solver::Options &opts = {},
+                                 std::vector<guillotine_solver::Workspace> *ws = nullptr) {
+    using namespace guillotine_solver;
+    PhaseTimes times;
+    RunControl run(opts.timeLimit, opts.progressEvery);
+    if (opts.timePhases) run.phases = &times;
+    const int threads = resolveThreads(opts.threads);
+    vector<Workspace> scratch;
+    if (!ws) ws = &scratch;
+    if ((int)ws->size() < threads) ws->resize(threads);
+
+    vector<Rect> R(inst.size());
+    for (int i = 0; i < inst.size(); ++i) {
+        const RankRect &r = inst.ranks[i];
+        R[i] = {r.x1, r.y1, r.x2, r.y2, inst.weights[i]};
+    }
+
+    Solution sol;
+    sol.selected = solveInstance(R, opts, threads, *ws, run);
+    sort(sol.selected.begin(), sol.selected.end());
+    sol.stats.value = inst.totalWeight(sol.selected);
+    sol.stats.timedOut = run.timedOut;
+    sol.stats.seconds = run.budget.elapsed();
+    for (int p = 0; p < PHASE_COUNT; ++p) sol.stats.phaseSeconds[p] = times.seconds(p);
+    run.counters.copyTo(sol.stats.counters);
+    return sol;
+}
+
+#endif // MISR_GUILLOTINE_SOLVER_H
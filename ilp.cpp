@@ -6,8 +6,41 @@
  * Formulation:
  *   - Variables: x_i ∈ {0,1} for each rectangle i (1 = selected, 0 = not selected)
  *   - Objective: maximize Σ w_i * x_i (sum of weights of selected rectangles)
- *   - Constraints: x_i + x_j ≤ 1 for any overlapping pair (i,j)
+ *   - Constraints (--formulation cliques, default): Σ_{i∈C} x_i ≤ 1 for every maximal set C of
+ *     rectangles covering a common point. These imply all pair constraints with far fewer rows
+ *     and give a tighter LP relaxation.
+ *   - Constraints (--formulation pairs): x_i + x_j ≤ 1 for any overlapping pair (i,j)
+ *
+ * Reductions:
+ *   Before the model is built, the exact rules of reduce.h (simplicial rectangles, domination)
+ *   fix or delete rectangles until nothing changes; the model covers only the rest.
+ *   --no-reduce skips them.
+ *
+ * Decomposition:
+ *   Rectangles in different connected components of the conflict graph never share a row, so
+ *   every component is solved as its own (much smaller) model and isolated rectangles are taken
+ *   directly. --no-decompose solves the instance as a single model. The component models run
+ *   in parallel, largest first, one GLPK environment per worker thread (--threads N, default
+ *   one per hardware thread; serial when GLPK was built without thread-local storage).
+ *
+ * Warm start:
+ *   --warm-start runs the local search (local_search.h) first and hands its solution to GLPK as
+ *   the first incumbent, so branch-and-bound can prune against it from the root node on.
+ *   --lower-bound V adds the row Σ w_i x_i ≥ V. V must be the weight of a feasible solution
+ *   (e.g. the guillotine DP output), otherwise the problem becomes infeasible.
+ *
+ * Time limit:
+ *   --time-limit S gives every instance S seconds, shared by its components (glp_iocp.tm_lim).
+ *   A component that runs out returns GLPK's incumbent, or the local-search solution if that is
+ *   better or there is none; the output then says it is the best solution found, not the
+ *   optimum. --progress S prints the incumbent and the node rate every S seconds on stderr.
+ *
+ * --stats prints the phase times, the branch-and-bound node count and the other counters of
+ * counters.h as one JSON line per instance on stderr.
  * 
+ * The solver itself is ilp_solver.h (solve_ilp); this file parses the options, reads the
+ * instances and prints the result.
+ *
  * Input Format:
  *   Line 1: n (number of rectangles)
  *   Next n lines: x1 y1 x2 y2 [weight]
@@ -18,145 +51,101 @@
 #include <iostream>
 #include <vector>
 #include <string>
-#include <sstream>
-#include <algorithm>
-#include <iomanip>
-#include <glpk.h>
+#include <cstdlib>
+#include "ilp_solver.h"
+#include "misr.h"
 
 using namespace std;
+using namespace ilp_solver;
 
-struct Rectangle {
-    double x1, y1, x2, y2;  // Bottom-left (x1,y1) to top-right (x2,y2)
-    double weight;
-};
-
-// Check if two rectangles overlap (touching edges/corners doesn't count)
-bool rectanglesOverlap(const Rectangle& a, const Rectangle& b) {
-    // No overlap if separated horizontally or vertically
-    if (min(a.x2, b.x2) <= max(a.x1, b.x1)) return false;
-    if (min(a.y2, b.y2) <= max(a.y1, b.y1)) return false;
-    return true;
-}
-
-int main() {
+int main(int argc, char** argv) {
     ios::sync_with_stdio(false);
-    cin.tie(nullptr);
-
-    // Read number of rectangles
-    int numRectangles;
-    if (!(cin >> numRectangles) || numRectangles <= 0) {
-        cerr << "Error: First line must be a positive integer.\n";
-        return 1;
-    }
 
-    // Read rectangle data
-    vector<Rectangle> rectangles(numRectangles);
-    for (int i = 0; i < numRectangles; i++) {
-        string line;
-        if (!getline(cin, line)) {
-            if (i == 0) getline(cin, line);  // Skip potential newline after n
-        }
-        if (line.empty()) getline(cin, line);
-        
-        istringstream iss(line);
-        double x1, y1, x2, y2, weight = 1.0;
-        
-        if (!(iss >> x1 >> y1 >> x2 >> y2)) {
-            cerr << "Error: Line " << (i+2) << " must have 4 coordinates (x1 y1 x2 y2 [weight]).\n";
-            return 1;
-        }
-        
-        iss >> weight;  // Optional weight (stays 1.0 if not provided)
-        
-        if (x1 >= x2 || y1 >= y2) {
-            cerr << "Error: Rectangle " << i << " must satisfy x1 < x2 and y1 < y2.\n";
+    // Parse options
+    Options opts;
+    bool batch = false;       // stream of instances, one result line each
+    bool stats = false;       // one JSON line of SolveStats per instance on stderr
+    for (int a = 1; a < argc; ++a) {
+        string arg = argv[a];
+        if (arg == "--formulation" && a + 1 < argc) {
+            string f = argv[++a];
+            if (f == "cliques") opts.cliqueRows = true;
+            else if (f == "pairs") opts.cliqueRows = false;
+            else { cerr << "Error: --formulation must be cliques or pairs.\n"; return 1; }
+        } else if (arg == "--no-reduce") {
+            opts.reduce = false;
+        } else if (arg == "--no-decompose") {
+            opts.decompose = false;
+        } else if (arg == "--threads" && a + 1 < argc) {
+            opts.threads = atoi(argv[++a]);
+        } else if (arg == "--warm-start") {
+            opts.warmStart = true;
+        } else if (arg == "--lower-bound" && a + 1 < argc) {
+            opts.haveLowerBound = true;
+            opts.lowerBound = atof(argv[++a]);
+        } else if (arg == "--time-limit" && a + 1 < argc) {
+            opts.timeLimit = atof(argv[++a]);
+        } else if (arg == "--progress" && a + 1 < argc) {
+            opts.progressEvery = atof(argv[++a]);
+        } else if (arg == "--batch") {
+            batch = true;
+        } else if (arg == "--stats") {
+            stats = opts.timePhases = true;
+        } else {
+            cerr << "Usage: " << argv[0]
+                 << " [--formulation cliques|pairs] [--warm-start] [--lower-bound V]"
+                    " [--no-reduce] [--no-decompose] [--threads N] [--time-limit S] [--progress S] [--stats] [--batch] < input\n";
             return 1;
         }
-        
-        rectangles[i] = {x1, y1, x2, y2, weight};
     }
-
-    // Find all pairs of overlapping rectangles
-    vector<pair<int,int>> conflictPairs;
-    conflictPairs.reserve(numRectangles * (numRectangles - 1) / 2);
-    
-    for (int i = 0; i < numRectangles; i++) {
-        for (int j = i + 1; j < numRectangles; j++) {
-            if (rectanglesOverlap(rectangles[i], rectangles[j])) {
-                conflictPairs.push_back({i, j});
-            }
-        }
-    }
-    
-    int numConflicts = conflictPairs.size();
-
-    // ========== Setup ILP Problem ==========
-    glp_prob* ilp = glp_create_prob();
-    glp_set_prob_name(ilp, "MISR");
-    glp_set_obj_dir(ilp, GLP_MAX);  // Maximize
-
-    // Create binary variables x_i for each rectangle
-    glp_add_cols(ilp, numRectangles);
-    for (int i = 1; i <= numRectangles; i++) {
-        glp_set_col_name(ilp, i, ("x_" + to_string(i)).c_str());
-        glp_set_col_bnds(ilp, i, GLP_DB, 0.0, 1.0);           // 0 ≤ x_i ≤ 1
-        glp_set_obj_coef(ilp, i, rectangles[i-1].weight);     // Objective coefficient
-        glp_set_col_kind(ilp, i, GLP_BV);                     // Binary variable
+    if (batch && opts.haveLowerBound) {
+        cerr << "Error: --lower-bound belongs to a single instance and cannot be used with --batch.\n";
+        return 1;
     }
 
-    // Add constraints: x_i + x_j ≤ 1 for each overlapping pair (i,j)
-    if (numConflicts > 0) {
-        glp_add_rows(ilp, numConflicts);
-        
-        // Build constraint matrix in coordinate format
-        int numNonZeros = 2 * numConflicts;
-        vector<int> rowIndices(numNonZeros + 1);
-        vector<int> colIndices(numNonZeros + 1);
-        vector<double> coefficients(numNonZeros + 1);
-
-        int idx = 0;
-        for (int row = 1; row <= numConflicts; row++) {
-            int i = conflictPairs[row-1].first;   // 0-based rectangle index
-            int j = conflictPairs[row-1].second;  // 0-based rectangle index
-            
-            string constraintName = "overlap_" + to_string(i) + "_" + to_string(j);
-            glp_set_row_name(ilp, row, constraintName.c_str());
-            glp_set_row_bnds(ilp, row, GLP_UP, 0.0, 1.0);  // x_i + x_j ≤ 1
-
-            // Add coefficients: 1.0 for x_i and 1.0 for x_j
-            rowIndices[++idx] = row;  colIndices[idx] = i + 1;  coefficients[idx] = 1.0;
-            rowIndices[++idx] = row;  colIndices[idx] = j + 1;  coefficients[idx] = 1.0;
+    Workspace ws;
+    InstanceReader in(0);   // stdin
+    Instance inst;
+    PhaseTimes reading;
+    PhaseTimes *readTimes = stats ? &reading : nullptr;
+
+    // Batch mode: one line per instance, the count followed by the selected indices
+    if (batch) {
+        int status;
+        while ((status = readInstance(in, inst, readTimes)) == 1) {
+            Solution sol = solve_ilp(inst, opts, &ws);
+            if (stats) writeStatsJson(stderr, "ilp", inst.size(), sol, readTimes);
+            reading.clear();
+            if (sol.status != 0) {
+                cerr << "Error: ILP solver failed with status " << sol.status << "\n";
+                return 1;
+            }
+            cout << sol.selected.size();
+            for (int idx : sol.selected) cout << " " << idx;
+            cout << "\n" << flush;
         }
-        
-        glp_load_matrix(ilp, numNonZeros, rowIndices.data(), colIndices.data(), coefficients.data());
+        return status < 0 ? 1 : 0;
     }
 
-    // ========== Solve ILP ==========
-    glp_iocp solverParams;
-    glp_init_iocp(&solverParams);
-    solverParams.presolve = GLP_ON;
-    solverParams.msg_lev = GLP_MSG_OFF;  // Suppress verbose output
+    int status = readInstance(in, inst, readTimes);
+    if (status == 0) cerr << "Error: First line must be a positive integer.\n";
+    if (status != 1) return 1;
 
-    int solveStatus = glp_intopt(ilp, &solverParams);
-    if (solveStatus != 0) {
-        cerr << "Error: ILP solver failed with status " << solveStatus << "\n";
-        glp_delete_prob(ilp);
+    Solution sol = solve_ilp(inst, opts, &ws);
+    if (stats) writeStatsJson(stderr, "ilp", inst.size(), sol, readTimes);
+    if (sol.status != 0) {
+        cerr << "Error: ILP solver failed with status " << sol.status << "\n";
         return 1;
     }
-
-    // ========== Extract Solution ==========
-    double totalWeight = glp_mip_obj_val(ilp);
-    vector<int> selectedRectangles;
-    
-    for (int i = 1; i <= numRectangles; i++) {
-        double value = glp_mip_col_val(ilp, i);
-        if (value > 0.5) {  // x_i = 1 (selected)  //coz of precision
-            selectedRectangles.push_back(i - 1);  // Convert to 0-based index
-        }
-    }
+    const vector<int> &selectedRectangles = sol.selected;
 
     // ========== Output Results ==========
-    cout << "\n=== OPTIMAL SOLUTION (ILP) ===\n";
+    if (sol.stats.timedOut) {
+        cerr << "Note: time limit reached; returning the best solution found.\n";
+        cout << "\n=== BEST SOLUTION FOUND (ILP, time limit) ===\n";
+    } else {
+        cout << "\n=== OPTIMAL SOLUTION (ILP) ===\n";
+    }
     cout << "Number of rectangles selected: " << selectedRectangles.size() << "\n";
     //cout << "Total weight: " << fixed << setprecision(2) << totalWeight << "\n";
     cout << "Selected rectangle indices: ";
@@ -165,6 +154,5 @@ int main() {
     }
     cout << "\n";
     cout << "\n";
-    glp_delete_prob(ilp);
     return 0;
 }
@@ -0,0 +1,420 @@
+/*
+ * ILP solver library (see ilp.cpp for the CLI and the formulation notes).
+ *
+ * solve_ilp maximizes the total weight of an Instance (misr.h) exactly with GLPK: exact
+ * reductions (reduce.h), one model per connected component of the conflict graph, point-clique
+ * or pairwise rows, an optional local-search warm start and objective cut, and a time limit
+ * after which the best known solution is returned. The model only needs which rectangles
+ * overlap, so it is built from the instance's ranks.
+ *
+ * The component models are independent MIPs and run concurrently, largest first, each worker
+ * thread with its own GLPK environment and problem object. That needs a GLPK built with
+ * thread-local storage (glp_config("TLS"), the default where the compiler supports it);
+ * otherwise they are solved one after another.
+ */
+
+#ifndef MISR_ILP_SOLVER_H
+#define MISR_ILP_SOLVER_H
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <glpk.h>
+#include "conflict_graph.h"
+#include "counters.h"
+#include "local_search.h"
+#include "misr.h"
+#include "parallel.h"
+#include "phase_times.h"
+#include "reduce.h"
+#include "time_budget.h"
+
+namespace ilp_solver {
+
+using namespace std;
+
+
+struct Rectangle {
+    double x1, y1, x2, y2;  // Bottom-left (x1,y1) to top-right (x2,y2)
+    double weight;
+};
+
+// Offers the warm-start solution (1-based column values) to the MIP search once, at the first
+// heuristic callback
+struct WarmStart {
+    vector<double> values;
+    bool offered = false;
+};
+
+// State of the branch-and-bound callback: the warm start (if any) and progress reporting, where
+// `base` is the weight already fixed outside the current model; `nodes` receives the number of
+// branch-and-bound nodes created so far
+struct SearchHooks {
+    WarmStart* warm = nullptr;
+    Progress* progress = nullptr;
+    double base = 0.0;
+    int nodes = 0;
+};
+
+inline void searchCallback(glp_tree* tree, void* info) {
+    SearchHooks* hooks = static_cast<SearchHooks*>(info);
+    WarmStart* warm = hooks->warm;
+    if (warm && glp_ios_reason(tree) == GLP_IHEUR && !warm->offered) {
+        warm->offered = true;
+        glp_ios_heur_sol(tree, warm->values.data());
+    }
+    glp_ios_tree_size(tree, nullptr, nullptr, &hooks->nodes);
+    if (hooks->progress && hooks->progress->enabled()) {
+        glp_prob* prob = glp_ios_get_prob(tree);
+        double best = hooks->base + (glp_mip_status(prob) == GLP_FEAS ? glp_mip_obj_val(prob) : 0.0);
+        hooks->progress->report(best, hooks->nodes, "nodes");
+    }
+}
+
+struct Options {
+    bool cliqueRows = true;   // one row per maximal point clique instead of per overlapping pair
+    bool warmStart = false;   // seed the MIP with a local-search solution
+    bool haveLowerBound = false;
+    double lowerBound = 0.0;  // objective ≥ this (weight of a known feasible solution)
+    bool decompose = true;    // solve connected components as separate models
+    bool reduce = true;       // apply the exact reductions of reduce.h first
+    int threads = 0;          // component models solved at once, 0 = one per hardware thread
+    double timeLimit = -1;    // seconds per instance, < 0 = unlimited
+    double progressEvery = 0; // seconds between progress lines, 0 = none
+    bool timePhases = false;  // fill SolveStats::phaseSeconds
+};
+
+// Buffers kept across components and instances (--batch): the GLPK problem object is erased
+// and refilled instead of recreated, and the conflict/matrix arrays keep their capacity. The
+// problem object belongs to the GLPK environment of the thread that created the workspace.
+struct Workspace {
+    glp_prob* ilp = glp_create_prob();
+    ConflictGraphBuilder builder;
+    ConflictGraph adj;
+    vector<vector<int>> conflictSets;
+    vector<int> rowIndices, colIndices;
+    vector<double> coefficients;
+    bool timedOut = false;    // some model of the last instance stopped at the time limit
+    PhaseTimes* phases = nullptr;   // per-phase timings (phase_times.h), if wanted
+    Counters* counters = nullptr;   // event counts (counters.h), if wanted
+
+    Workspace() = default;
+    Workspace(const Workspace&) = delete;
+    Workspace& operator=(const Workspace&) = delete;
+    ~Workspace() { glp_delete_prob(ilp); }
+};
+
+// Greedy start plus local search (local_search.h) over `rectangles`: the warm start, and the
+// answer of a model that runs out of time. Weighted instances start from the weight /
+// (degree + 1) greedy and use the weighted moves, which select no rectangle of weight <= 0.
+inline vector<int> localSearchSolution(const vector<Rectangle> &rectangles, Workspace &ws) {
+    const int n = rectangles.size();
+    ConflictGraph &adj = ws.adj;
+    ws.builder.build(rectangles, adj);
+    vector<double> weights;
+    for (const Rectangle &r : rectangles)
+        if (r.weight != 1.0) { weights.resize(n); break; }
+    for (size_t i = 0; i < weights.size(); i++) weights[i] = rectangles[i].weight;
+    LocalSearch search(adj, weights.empty() ? nullptr : &weights);
+    if (weights.empty()) search.run(greedySweep(rectangles, greedyOrder(rectangles, adj, GreedyStrategy::RightEdge)));
+    else search.run(greedyInit(adj, greedyOrder(rectangles, adj, GreedyStrategy::WeightPerConflict, 0.0, nullptr, &weights), &weights));
+    if (ws.counters) ws.counters->add(search.tally);
+    return search.solution();
+}
+
+inline double totalWeight(const vector<Rectangle> &rectangles, const vector<int> &ids) {
+    double w = 0.0;
+    for (int i : ids) w += rectangles[i].weight;
+    return w;
+}
+
+// Builds and solves the MISR model over `rectangles`; `selected` receives 0-based indices.
+// Returns 0 on success, the glp_intopt status otherwise (-1 if the root LP failed). When the
+// budget runs out the best known solution is returned with status 0 and ws.timedOut set;
+// `base` is the weight already selected elsewhere (for progress lines only).
+inline int solveModel(const vector<Rectangle> &rectangles, const Options &opts, double lowerBound,
+                      const TimeBudget &budget, Progress &progress, double base,
+                      Workspace &ws, vector<int> &selected) {
+    const int n = rectangles.size();
+    const bool cliqueRows = opts.cliqueRows, warmStart = opts.warmStart, haveLowerBound = opts.haveLowerBound;
+    PhaseTimer timer(ws.phases, PHASE_GRAPH);
+
+    // Conflict sets: maximal point cliques (sweep, see conflict_graph.h) or overlapping pairs
+    vector<vector<int>> &conflictSets = ws.conflictSets;
+    if (cliqueRows) {
+        conflictSets = maximalPointCliques(rectangles);
+    } else {
+        const auto &pairs = ws.builder.pairs(rectangles);
+        conflictSets.resize(pairs.size());
+        for (size_t k = 0; k < pairs.size(); k++) conflictSets[k].assign({pairs[k].first, pairs[k].second});
+    }
+    
+    int numConflicts = conflictSets.size();
+
+    // Out of time before the model is even built: fall back to local search
+    if (budget.expired()) {
+        ws.timedOut = true;
+        selected = localSearchSolution(rectangles, ws);
+        return 0;
+    }
+
+    // ========== Setup ILP Problem ==========
+    timer.next(PHASE_INIT);
+    glp_prob* ilp = ws.ilp;
+    glp_erase_prob(ilp);
+    glp_set_prob_name(ilp, "MISR");
+    glp_set_obj_dir(ilp, GLP_MAX);  // Maximize
+
+    // Create binary variables x_i for each rectangle
+    glp_add_cols(ilp, n);
+    for (int i = 1; i <= n; i++) {
+        glp_set_col_name(ilp, i, ("x_" + to_string(i)).c_str());
+        glp_set_col_bnds(ilp, i, GLP_DB, 0.0, 1.0);           // 0 ≤ x_i ≤ 1
+        glp_set_obj_coef(ilp, i, rectangles[i-1].weight);     // Objective coefficient
+        glp_set_col_kind(ilp, i, GLP_BV);                     // Binary variable
+    }
+
+    // Add constraints: Σ_{i∈C} x_i ≤ 1 for each conflict set C (a pair or a point clique)
+    if (numConflicts > 0) {
+        glp_add_rows(ilp, numConflicts);
+        
+        // Build constraint matrix in coordinate format
+        int numNonZeros = 0;
+        for (const auto &set : conflictSets) numNonZeros += set.size();
+        vector<int> &rowIndices = ws.rowIndices, &colIndices = ws.colIndices;
+        vector<double> &coefficients = ws.coefficients;
+        rowIndices.resize(numNonZeros + 1);
+        colIndices.resize(numNonZeros + 1);
+        coefficients.resize(numNonZeros + 1);
+
+        int idx = 0;
+        for (int row = 1; row <= numConflicts; row++) {
+            const vector<int> &set = conflictSets[row-1];   // 0-based rectangle indices
+            
+            string constraintName = cliqueRows ? "clique_" + to_string(row)
+                                               : "overlap_" + to_string(set[0]) + "_" + to_string(set[1]);
+            glp_set_row_name(ilp, row, constraintName.c_str());
+            glp_set_row_bnds(ilp, row, GLP_UP, 0.0, 1.0);  // Σ x_i ≤ 1
+
+            // Add coefficients: 1.0 for every member of the set
+            for (int i : set) {
+                rowIndices[++idx] = row;  colIndices[idx] = i + 1;  coefficients[idx] = 1.0;
+            }
+        }
+        
+        glp_load_matrix(ilp, numNonZeros, rowIndices.data(), colIndices.data(), coefficients.data());
+    }
+
+    // Objective cut: Σ w_i x_i ≥ lowerBound
+    if (haveLowerBound) {
+        int row = glp_add_rows(ilp, 1);
+        glp_set_row_name(ilp, row, "lower_bound");
+        glp_set_row_bnds(ilp, row, GLP_LO, lowerBound, 0.0);
+        vector<int> cols(n + 1);
+        vector<double> weights(n + 1);
+        for (int i = 1; i <= n; i++) { cols[i] = i; weights[i] = rectangles[i-1].weight; }
+        glp_set_mat_row(ilp, row, n, cols.data(), weights.data());
+    }
+
+    // ========== Warm Start (local search) ==========
+    WarmStart warm;
+    vector<int> heuristic;
+    if (warmStart) {
+        heuristic = localSearchSolution(rectangles, ws);
+        warm.values.assign(n + 1, 0.0);
+        for (int i : heuristic) warm.values[i + 1] = 1.0;
+        // An incumbent violating the objective cut would be rejected anyway
+        if (haveLowerBound && totalWeight(rectangles, heuristic) < lowerBound) warm.offered = true;
+    }
+
+    // ========== Solve ILP ==========
+    timer.next(PHASE_SEARCH);
+    glp_iocp solverParams;
+    glp_init_iocp(&solverParams);
+    solverParams.presolve = GLP_ON;
+    solverParams.msg_lev = GLP_MSG_OFF;  // Suppress verbose output
+    if (budget.limited()) solverParams.tm_lim = (int)min(budget.remaining() * 1000.0, 2.0e9);
+
+    SearchHooks hooks;
+    hooks.progress = &progress;
+    hooks.base = base;
+    if (progress.enabled() || (COUNTERS_ENABLED && ws.counters)) {
+        solverParams.cb_func = searchCallback;
+        solverParams.cb_info = &hooks;
+    }
+    if (warmStart) {
+        // The heuristic callback needs the original columns, so solve the root LP ourselves
+        // instead of letting the MIP presolver rewrite the problem
+        glp_smcp lpParams;
+        glp_init_smcp(&lpParams);
+        lpParams.msg_lev = GLP_MSG_OFF;
+        lpParams.tm_lim = solverParams.tm_lim;
+        int lpStatus = glp_simplex(ilp, &lpParams);
+        if (lpStatus == GLP_ETMLIM) {
+            ws.timedOut = true;
+            selected = heuristic;
+            return 0;
+        }
+        if (lpStatus != 0) return -1;
+        solverParams.presolve = GLP_OFF;
+        solverParams.cb_func = searchCallback;
+        solverParams.cb_info = &hooks;
+        hooks.warm = &warm;
+    }
+
+    int solveStatus = glp_intopt(ilp, &solverParams);
+    if (ws.counters) ws.counters->add(CTR_BB_NODES, hooks.nodes);
+    if (solveStatus != 0 && solveStatus != GLP_ETMLIM) return solveStatus;
+
+    // ========== Extract Solution ==========
+    // On a timeout the incumbent (if any) competes with the local-search solution
+    timer.next(PHASE_RECONSTRUCT);
+    const bool haveSolution = solveStatus == 0 || glp_mip_status(ilp) == GLP_FEAS;
+    if (haveSolution) {
+        for (int i = 1; i <= n; i++) {
+            double value = glp_mip_col_val(ilp, i);
+            if (value > 0.5) {  // x_i = 1 (selected)  //coz of precision
+                selected.push_back(i - 1);  // Convert to 0-based index
+            }
+        }
+    }
+    if (solveStatus == GLP_ETMLIM) {
+        ws.timedOut = true;
+        if (!warmStart) heuristic = localSearchSolution(rectangles, ws);
+        if (!haveSolution || totalWeight(rectangles, heuristic) > totalWeight(rectangles, selected)) selected = heuristic;
+    }
+    return 0;
+}
+
+// Solves one instance into selectedRectangles (sorted 0-based indices). Returns 0 on success,
+// the failing solver status otherwise.
+inline int solveInstance(const vector<Rectangle> &rectangles, const Options &opts, Workspace &ws,
+                         vector<int> &selectedRectangles) {
+    const TimeBudget budget(opts.timeLimit);
+    Progress progress(budget, opts.progressEvery);
+    ws.timedOut = false;
+    PhaseTimer timer(ws.phases, PHASE_GRAPH);
+
+    // ========== Reduce (reduce.h) ==========
+    // Fixed rectangles go straight into the solution; the model only sees red.kept
+    const int n = rectangles.size();
+    double lowerBound = opts.lowerBound;
+    ConflictGraph &adj = ws.adj;
+    ws.builder.build(rectangles, adj);
+    if (ws.counters) ws.counters->add(CTR_CONFLICT_EDGES, adj.edgeCount());
+    Reduction red;
+    if (opts.reduce) {
+        vector<double> weights(n);
+        for (int i = 0; i < n; i++) weights[i] = rectangles[i].weight;
+        red = reduceConflictGraph(adj, weights);
+        for (int i : red.taken) lowerBound -= rectangles[i].weight;
+    } else {
+        red.kept.resize(n);
+        for (int i = 0; i < n; i++) red.kept[i] = i;
+    }
+
+    // ========== Decompose ==========
+    // The objective cut couples all rectangles, so --lower-bound keeps the instance whole
+    vector<vector<int>> components;
+    if (opts.decompose && !opts.haveLowerBound) {
+        components = connectedComponents(inducedSubgraph(adj, red.kept));
+        for (auto &members : components)
+            for (int &i : members) i = red.kept[i];
+    } else if (!red.kept.empty()) {
+        components.push_back(red.kept);
+    }
+
+    // ========== Solve each component ==========
+    // Isolated rectangles are taken directly (if they add weight). The other components are
+    // models, handed out largest first to the workers (longest processing time first), so the
+    // big ones do not start last. Worker 0 is this thread and uses ws; the others create their
+    // workspace, and with it their GLPK environment, on their own thread and free both there.
+    // adj is not read past this point; the warm start reuses its storage.
+    timer.stop();
+    selectedRectangles = red.taken;
+    vector<const vector<int> *> models;
+    for (const vector<int> &members : components) {
+        if (members.size() == 1 && components.size() > 1) {
+            if (rectangles[members[0]].weight > 0) selectedRectangles.push_back(members[0]);
+        } else {
+            models.push_back(&members);
+        }
+    }
+    stable_sort(models.begin(), models.end(), [](const vector<int> *a, const vector<int> *b) {
+        return a->size() > b->size();
+    });
+
+    const bool threadSafe = glp_config("TLS") != nullptr;
+    const int workers = (int)min<size_t>(threadSafe ? (size_t)resolveThreads(opts.threads) : 1, models.size());
+    vector<vector<int>> chosen(models.size());
+    vector<int> status(models.size(), 0);
+    atomic<size_t> next{0};
+    atomic<bool> failed{false}, timedOut{false};
+    atomic<double> finished{totalWeight(rectangles, selectedRectangles)};   // progress base
+    runWorkers(workers, [&](int w) {
+        unique_ptr<Workspace> own;
+        if (w > 0) {
+            own = make_unique<Workspace>();
+            own->phases = ws.phases;
+            own->counters = ws.counters;
+        }
+        Workspace &local = w > 0 ? *own : ws;
+        for (size_t m; !failed && (m = next.fetch_add(1)) < models.size();) {
+            vector<Rectangle> part;
+            for (int i : *models[m]) part.push_back(rectangles[i]);
+            status[m] = solveModel(part, opts, lowerBound, budget, progress, finished, local, chosen[m]);
+            if (status[m] != 0) failed = true;
+            const double gained = totalWeight(part, chosen[m]);
+            for (double f = finished; !finished.compare_exchange_weak(f, f + gained);) {}
+        }
+        timedOut = timedOut || local.timedOut;
+        if (w > 0) {
+            own.reset();
+            glp_free_env();
+        }
+    });
+    ws.timedOut = timedOut;
+    for (size_t m = 0; m < models.size(); ++m) {
+        if (status[m] != 0) return status[m];
+        for (int i : chosen[m]) selectedRectangles.push_back((*models[m])[i]);
+    }
+    PhaseTimer reconstruct(ws.phases, PHASE_RECONSTRUCT);
+    sort(selectedRectangles.begin(), selectedRectangles.end());
+    return 0;
+}
+
+} // namespace ilp_solver
+
+// Solves inst; ws keeps the GLPK problem object and the buffers across calls, as --batch does.
+// Without it a temporary workspace is used. Solution::status is 0 or the failing GLPK status.
+inline Solution solve_ilp(const Instance &inst, const ilp_solver::Options &opts = {}, ilp_solver::Workspace *ws = nullptr) {
+    using namespace ilp_solver;
+    const TimeBudget clock;
+    PhaseTimes times;
+    Counters counters;
+    unique_ptr<Workspace> scratch;
+    if (!ws) { scratch = make_unique<Workspace>(); ws = scratch.get(); }
+    ws->phases = opts.timePhases ? &times : nullptr;
+    ws->counters = &counters;
+
+    vector<Rectangle> rectangles(inst.size());
+    for (int i = 0; i < inst.size(); i++) {
+        const RankRect &r = inst.ranks[i];
+        rectangles[i] = {(double)r.x1, (double)r.y1, (double)r.x2, (double)r.y2, inst.weights[i]};
+    }
+
+    Solution sol;
+    sol.status = solveInstance(rectangles, opts, *ws, sol.selected);
+    ws->phases = nullptr;
+    ws->counters = nullptr;
+    sol.stats.value = inst.totalWeight(sol.selected);
+    sol.stats.timedOut = ws->timedOut;
+    sol.stats.seconds = clock.elapsed();
+    for (int p = 0; p < PHASE_COUNT; ++p) sol.stats.phaseSeconds[p] = times.seconds(p);
+    counters.copyTo(sol.stats.counters);
+    return sol;
+}
+
+#endif // MISR_ILP_SOLVER_H
@@ -0,0 +1,200 @@
+/*
+ * Shared fast input reader for the MISR solvers.
+ *
+ * A regular file on the input descriptor (./solver < file) is mmapped and parsed in place;
+ * pipes are read through a growing buffer that is refilled on demand, so --batch streams still
+ * get each result as soon as its instance has arrived. Numbers are parsed with
+ * std::from_chars, without locale or stream state.
+ *
+ * Two instance formats are accepted and detected per instance:
+ *   - Text (unchanged): "n" followed by n lines "x1 y1 x2 y2 [weight]".
+ *   - Binary: a 24-byte BinaryHeader ("MISRBIN1", flags, reserved, n) followed by n packed
+ *     little-endian records of x1, y1, x2, y2 [, weight], each 8 bytes. Coordinates are int64,
+ *     or float64 with MISR_BIN_FLOAT; the weight is always float64. In a mmapped file the
+ *     records are read where they lie and only converted (memcpy, int64 to double) into the
+ *     Instance, with no text parsing.
+ * writeBinaryInstance produces the binary format (see misr_convert.cpp).
+ */
+
+#ifndef MISR_INSTANCE_H
+#define MISR_INSTANCE_H
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+constexpr char MISR_BINARY_MAGIC[8] = {'M', 'I', 'S', 'R', 'B', 'I', 'N', '1'};
+constexpr uint32_t MISR_BIN_FLOAT = 1;     // coordinates are float64 instead of int64
+constexpr uint32_t MISR_BIN_WEIGHTS = 2;   // every record carries a float64 weight
+
+struct BinaryHeader {
+    char magic[8];
+    uint32_t flags;
+    uint32_t reserved;
+    uint64_t count;
+
+    size_t recordBytes() const { return (flags & MISR_BIN_WEIGHTS) ? 40 : 32; }
+};
+static_assert(sizeof(BinaryHeader) == 24, "binary header must stay 24 bytes");
+
+// View of one packed binary record: fields 0..3 are x1, y1, x2, y2, field 4 the weight
+struct BinaryRecord {
+    const char *at;
+    uint32_t flags;
+
+    bool floatCoords() const { return flags & MISR_BIN_FLOAT; }
+    double coord(int k) const {
+        if (floatCoords()) { double v; std::memcpy(&v, at + 8 * k, 8); return v; }
+        int64_t v; std::memcpy(&v, at + 8 * k, 8); return (double)v;
+    }
+    double weight() const {
+        if (!(flags & MISR_BIN_WEIGHTS)) return 1.0;
+        double v; std::memcpy(&v, at + 32, 8); return v;
+    }
+};
+
+class InstanceReader {
+public:
+    explicit InstanceReader(int fd = 0) : fd(fd) {
+        struct stat st;
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+            void *m = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (m != MAP_FAILED) {
+                madvise(m, (size_t)st.st_size, MADV_SEQUENTIAL);
+                map = m; mapLen = (size_t)st.st_size;
+                p = (const char *)m; end = p + mapLen;
+                eof = true;
+                return;
+            }
+        }
+        buf.resize(1 << 16);
+        p = end = buf.data();
+    }
+    ~InstanceReader() { if (map) munmap(map, mapLen); }
+    InstanceReader(const InstanceReader &) = delete;
+    InstanceReader &operator=(const InstanceReader &) = delete;
+
+    // True when only whitespace is left
+    bool done() {
+        skipSpace(false);
+        return p == end && !refill(1);
+    }
+
+    // True if the next instance is in the binary format
+    bool atBinary() {
+        skipSpace(false);
+        return available(8) && std::memcmp(p, MISR_BINARY_MAGIC, 8) == 0;
+    }
+
+    bool readHeader(BinaryHeader &h) {
+        if (!available(sizeof h)) return false;
+        std::memcpy(&h, p, sizeof h);
+        p += sizeof h;
+        return std::memcmp(h.magic, MISR_BINARY_MAGIC, 8) == 0;
+    }
+
+    // The next `count` records, or nullptr on a truncated file. The pointer stays valid until
+    // the next read (for the whole reader lifetime when the input is mmapped).
+    const char *records(const BinaryHeader &h) {
+        size_t bytes = h.recordBytes() * (size_t)h.count;
+        if (!available(bytes)) return nullptr;
+        const char *at = p;
+        p += bytes;
+        return at;
+    }
+    BinaryRecord record(const char *records, const BinaryHeader &h, size_t i) const {
+        return {records + i * h.recordBytes(), h.flags};
+    }
+
+    // Next whitespace-separated number; sameLine = only look before the next newline
+    bool next(long long &v, bool sameLine = false) { return parse(v, sameLine); }
+    bool next(int &v, bool sameLine = false) { return parse(v, sameLine); }
+    bool next(double &v, bool sameLine = false) { return parse(v, sameLine); }
+
+private:
+    int fd;
+    const char *p = nullptr, *end = nullptr;
+    void *map = nullptr;
+    size_t mapLen = 0;
+    std::vector<char> buf;
+    bool eof = false;
+
+    static bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' || c == '\v'; }
+
+    // Reads more input until at least `need` unread bytes are buffered; false at end of input
+    bool refill(size_t need) {
+        while ((size_t)(end - p) < need) {
+            if (eof) return false;
+            size_t have = end - p;
+            if (p != buf.data()) std::memmove(buf.data(), p, have);
+            if (buf.size() < need) buf.resize(std::max(need, 2 * buf.size()));
+            p = buf.data(); end = p + have;
+            ssize_t got;
+            do got = ::read(fd, buf.data() + have, buf.size() - have); while (got < 0 && errno == EINTR);
+            if (got <= 0) { eof = true; continue; }
+            end += got;
+        }
+        return true;
+    }
+    bool available(size_t need) { return (size_t)(end - p) >= need || refill(need); }
+
+    // Skips whitespace; with sameLine it stops in front of a newline
+    void skipSpace(bool sameLine) {
+        for (;;) {
+            while (p < end && isSpace(*p) && !(sameLine && *p == '\n')) ++p;
+            if (p < end || !refill(1)) return;
+        }
+    }
+
+    template <class T>
+    bool parse(T &v, bool sameLine) {
+        skipSpace(sameLine);
+        if (p == end || *p == '\n') return false;
+        // Make sure the whole token is buffered before parsing it
+        size_t len = 0;
+        for (;;) {
+            while (p + len < end && !isSpace(p[len])) ++len;
+            if (p + len < end || !refill(len + 1)) break;
+        }
+        const char *b = p;
+        if (*b == '+') ++b;   // from_chars does not take a leading '+'
+        auto res = std::from_chars(b, p + len, v);
+        if (res.ec != std::errc() || res.ptr != p + len) return false;
+        p += len;
+        return true;
+    }
+};
+
+// Writes one instance in the binary format. coords holds 4 values per rectangle (x1 y1 x2 y2);
+// weights may be empty. With floatCoords the coordinates are stored as float64, else as int64.
+inline bool writeBinaryInstance(FILE *out, const std::vector<double> &coords, const std::vector<double> &weights,
+                                bool floatCoords) {
+    BinaryHeader h;
+    std::memcpy(h.magic, MISR_BINARY_MAGIC, 8);
+    h.flags = (floatCoords ? MISR_BIN_FLOAT : uint32_t(0)) | (weights.empty() ? uint32_t(0) : MISR_BIN_WEIGHTS);
+    h.reserved = 0;
+    h.count = coords.size() / 4;
+    if (fwrite(&h, sizeof h, 1, out) != 1) return false;
+
+    char rec[40];
+    for (size_t i = 0; i < h.count; ++i) {
+        for (int k = 0; k < 4; ++k) {
+            double c = coords[4 * i + k];
+            if (floatCoords) std::memcpy(rec + 8 * k, &c, 8);
+            else { int64_t v = (int64_t)c; std::memcpy(rec + 8 * k, &v, 8); }
+        }
+        if (!weights.empty()) std::memcpy(rec + 32, &weights[i], 8);
+        if (fwrite(rec, h.recordBytes(), 1, out) != 1) return false;
+    }
+    return true;
+}
+
+#endif // MISR_INSTANCE_H
@@ -0,0 +1,660 @@
+/*
+ * MISR local-search engine, shared by localsearch.cpp and the ILP warm start.
+ *
+ * Greedy initializers build a start solution: a right-edge sweep over a max segment tree on y
+ * (O(n log n), no conflict graph needed), or any order with neighbor blocking (O(n + m)).
+ * Callers running them once per task pass a GreedyScratch to the *Into variants, which then
+ * allocate nothing once the buffers have grown.
+ * LocalSearch then applies (0,1) insertions and (1,2) swaps until a local optimum, keeping the
+ * number of selected neighbors of every rectangle up to date through the conflict graph. The
+ * solution is an indexed set (members plus each member's position, removal swaps the last one
+ * in): adding or removing a member is O(1) on the set plus O(deg) to update its neighbors'
+ * counts, and solution() sorts the members in O(|S| log |S|) instead of scanning all n flags.
+ *
+ * With weights the objective is the total weight: a swap is applied when it gains weight, and only
+ * rectangles of positive weight are ever selected (the greedy starts skip the others, and neither
+ * insertions nor swaps take them in). The weighted moves are (1,1), (1,2) (two
+ * 1-tight neighbors of u outweighing u) and (2,1) (a rectangle whose two selected neighbors
+ * weigh less than it does).
+ *
+ * With maxK = 2 or 3, a (k, k+1) phase follows the descent. Removal sets S of up to maxK
+ * selected rectangles are enumerated around each solution member, restricted to sets that are
+ * connected through shared candidates (an unselected rectangle overlapping both); the insertion
+ * candidates are the rectangles whose selected neighbors all lie in S, and a bounded-depth
+ * search over their conflict bitsets looks for |S| + 1 of them that are pairwise disjoint (or,
+ * weighted, at most |S| + 1 that outweigh S). After a move only the members near the change are
+ * re-examined. The phase stops at `swapDeadline` between two moves; the descent that follows a
+ * move is bounded by `deadline` only, so the solution left is (1,2)-optimal.
+ *
+ * `deadline` bounds the whole run: a descent that reaches it stops between two moves and keeps
+ * its current (always independent) solution. `progress`, if set, is called every 256 examined
+ * solution members.
+ *
+ * Rectangle types only need members x1, y1, x2, y2. The search runs on any graph with size(),
+ * begin(v) and end(v): the CSR ConflictGraph, or a DynamicConflictGraph that changes between
+ * descents (attach / detach, DynamicSolver in local_solver.h).
+ */
+
+#ifndef MISR_LOCAL_SEARCH_H
+#define MISR_LOCAL_SEARCH_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <vector>
+#include "bitset_kernel.h"
+#include "conflict_graph.h"
+#include "counters.h"
+
+// Greedy scan orders: right edge (earliest finish time), smallest area, fewest conflicts,
+// largest weight / (degree + 1) (the GWMIN rule for weighted instances)
+enum class GreedyStrategy { RightEdge, SmallestArea, FewestConflicts, WeightPerConflict };
+
+// Max over elementary y-intervals with range "raise to at least v" updates, O(log n) each
+struct MaxSegmentTree {
+    int size;
+    std::vector<double> best, raised;   // max in subtree / value applied to the whole subtree
+
+    explicit MaxSegmentTree(int m = 0) { reset(m); }
+
+    // All values back to -inf over m elementary intervals; keeps the capacity
+    void reset(int m) {
+        size = std::max(m, 1);
+        best.assign(4 * size, -HUGE_VAL);
+        raised.assign(4 * size, -HUGE_VAL);
+    }
+
+    void raise(int lo, int hi, double v) { raise(1, 0, size, lo, hi, v); }
+    double query(int lo, int hi) const { return query(1, 0, size, lo, hi); }
+
+private:
+    void raise(int node, int l, int r, int lo, int hi, double v) {
+        if (hi <= l || r <= lo) return;
+        if (lo <= l && r <= hi) { raised[node] = std::max(raised[node], v); best[node] = std::max(best[node], v); return; }
+        int mid = (l + r) / 2;
+        raise(2 * node, l, mid, lo, hi, v);
+        raise(2 * node + 1, mid, r, lo, hi, v);
+        best[node] = std::max(raised[node], std::max(best[2 * node], best[2 * node + 1]));
+    }
+    double query(int node, int l, int r, int lo, int hi) const {
+        if (hi <= l || r <= lo) return -HUGE_VAL;
+        if (lo <= l && r <= hi) return best[node];
+        int mid = (l + r) / 2;
+        return std::max(raised[node], std::max(query(2 * node, l, mid, lo, hi), query(2 * node + 1, mid, r, lo, hi)));
+    }
+};
+
+// Buffers of the greedy functions, kept by callers that run them for many tasks
+struct GreedyScratch {
+    std::vector<double> key, ys;
+    std::vector<char> blocked;
+    MaxSegmentTree tree;
+};
+
+// Indices sorted by the strategy's key. With jitter > 0 every key is perturbed (right edge: by up
+// to jitter * average width, area and weight: by up to a factor 1 + jitter, degree: random
+// tie-breaking), giving a different order per restart. weights may be null (all 1).
+template <class R, class Graph>
+void greedyOrderInto(std::vector<int> &p, GreedyScratch &scratch, const std::vector<R>& rects, const Graph& adj,
+                     GreedyStrategy strategy, double jitter = 0.0, std::mt19937_64* rng = nullptr,
+                     const std::vector<double>* weights = nullptr) {
+    int n = rects.size();
+    p.resize(n);
+    for(int i=0; i<n; ++i) p[i] = i;
+
+    double avgWidth = 0;
+    for (const R& r : rects) avgWidth += (r.x2 - r.x1) / std::max(n, 1);
+    std::uniform_real_distribution<double> noise(0.0, 1.0);
+    std::vector<double> &key = scratch.key;
+    key.resize(n);
+    for (int i = 0; i < n; ++i) {
+        double u = jitter > 0 ? jitter * noise(*rng) : 0.0;
+        const R& r = rects[i];
+        switch (strategy) {
+            case GreedyStrategy::RightEdge:       key[i] = r.x2 + u * avgWidth; break;
+            case GreedyStrategy::SmallestArea:    key[i] = (r.x2 - r.x1) * (r.y2 - r.y1) * (1.0 + u); break;
+            case GreedyStrategy::FewestConflicts: key[i] = adj.degree(i) + 0.5 * u; break;
+            case GreedyStrategy::WeightPerConflict:
+                key[i] = -(weights ? (*weights)[i] : 1.0) / (adj.degree(i) + 1) * (1.0 + u);
+                break;
+        }
+    }
+
+    // Stable by index without stable_sort's temporary buffer
+    std::sort(p.begin(), p.end(), [&](int a, int b) {
+        return key[a] != key[b] ? key[a] < key[b] : a < b;
+    });
+}
+
+template <class R>
+std::vector<int> greedyOrder(const std::vector<R>& rects, const ConflictGraph& adj, GreedyStrategy strategy,
+                             double jitter = 0.0, std::mt19937_64* rng = nullptr,
+                             const std::vector<double>* weights = nullptr) {
+    std::vector<int> p;
+    GreedyScratch scratch;
+    greedyOrderInto(p, scratch, rects, adj, strategy, jitter, rng, weights);
+    return p;
+}
+
+// Right-edge greedy as a sweep; `order` must be sorted by x2. A selected rectangle s precedes
+// the candidate c, so s.x2 <= c.x2 and they overlap iff their y-ranges overlap and s.x2 > c.x1.
+// The tree keeps, per elementary y-interval, the largest x2 of a selected rectangle over it.
+// O(n log n), and it needs no conflict graph. With weights, rectangles of weight <= 0 are skipped.
+template <class R>
+void greedySweepInto(std::vector<int> &solution, GreedyScratch &scratch, const std::vector<R>& rects,
+                     const std::vector<int>& order, const std::vector<double>* weights = nullptr) {
+    std::vector<double> &ys = scratch.ys;
+    ys.clear();
+    for (const R& r : rects) { ys.push_back(r.y1); ys.push_back(r.y2); }
+    std::sort(ys.begin(), ys.end());
+    ys.erase(std::unique(ys.begin(), ys.end()), ys.end());
+    auto yIndex = [&](double y) { return (int)(std::lower_bound(ys.begin(), ys.end(), y) - ys.begin()); };
+
+    MaxSegmentTree &rightmost = scratch.tree;
+    rightmost.reset((int)ys.size() - 1);
+    solution.clear();
+    for (int idx : order) {
+        if (weights && (*weights)[idx] <= 0) continue;
+        const R& c = rects[idx];
+        int lo = yIndex(c.y1), hi = yIndex(c.y2);
+        if (rightmost.query(lo, hi) > c.x1) continue;
+        rightmost.raise(lo, hi, c.x2);
+        solution.push_back(idx);
+    }
+}
+
+template <class R>
+std::vector<int> greedySweep(const std::vector<R>& rects, const std::vector<int>& order,
+                             const std::vector<double>* weights = nullptr) {
+    std::vector<int> solution;
+    GreedyScratch scratch;
+    greedySweepInto(solution, scratch, rects, order, weights);
+    return solution;
+}
+
+// Greedy for an arbitrary order: selecting a rectangle blocks its conflict-graph neighbors. O(n + m)
+// With weights, rectangles of weight <= 0 are skipped.
+template <class Graph>
+void greedyInitInto(std::vector<int> &solution, GreedyScratch &scratch, const Graph& adj, const std::vector<int>& order,
+                    const std::vector<double>* weights = nullptr) {
+    std::vector<char> &blocked = scratch.blocked;
+    blocked.assign(adj.size(), 0);
+    solution.clear();
+    for (int idx : order) {
+        if (blocked[idx] || (weights && (*weights)[idx] <= 0)) continue;
+        solution.push_back(idx);
+        for (const int *p = adj.begin(idx); p != adj.end(idx); ++p) blocked[*p] = 1;
+    }
+}
+
+inline std::vector<int> greedyInit(const ConflictGraph& adj, const std::vector<int>& order,
+                                   const std::vector<double>* weights = nullptr) {
+    std::vector<int> solution;
+    GreedyScratch scratch;
+    greedyInitInto(solution, scratch, adj, order, weights);
+    return solution;
+}
+
+// Removal sets larger than this are not tried
+constexpr int LOCAL_SEARCH_MAX_K = 3;
+// Removal sets with more insertion candidates than this are skipped
+constexpr int KSWAP_MAX_CANDIDATES = 512;
+
+// Incremental (0,1) / (1,2) local search over a conflict graph; with weights also the weighted
+// (1,1) and (2,1) moves, and with maxK > 1 the (k, k+1) moves
+template <class Graph = ConflictGraph>
+struct BasicLocalSearch {
+    const Graph *adj = nullptr;
+    const std::vector<double> *weights = nullptr;   // null: unweighted, every rectangle counts 1
+    std::vector<char> isSelected;
+    std::vector<int> members;       // the solution, in no particular order
+    std::vector<int> position;      // members[position[v]] == v for selected v
+    std::vector<int> solCount;      // number of selected neighbors of each rectangle
+    std::vector<int> freeList;      // unselected rectangles whose solCount dropped to 0
+    std::vector<int> dirty;         // solution members whose 1-tight neighborhood changed
+    std::vector<char> queued;
+    int size = 0;
+    double totalWeight = 0;
+
+    // Scratch space of trySwap, reused across calls
+    std::vector<int> candidates, localIndex;
+    std::vector<uint64_t> allBits, conflictBits;
+
+    // Run settings: set after reset(), before run()
+    using Clock = std::chrono::steady_clock;
+    int maxK = 1;
+    Clock::time_point deadline = Clock::time_point::max();       // whole run
+    Clock::time_point swapDeadline = Clock::time_point::max();   // (k, k+1) phase
+    std::function<void(const BasicLocalSearch &)> progress;
+
+    bool timedOut = false;          // stopped at a deadline
+    uint64_t moves = 0;             // applied insertions and swaps
+    Tally tally;                    // moves tried / applied by type (counters.h)
+
+    // (k, k+1) phase state
+    std::vector<int> kQueue, changeLog, removal, touched, chosen, nearU, nearA;
+    std::vector<int> hits;          // per rectangle: selected neighbors inside the removal set
+    std::vector<char> kQueued;
+    std::vector<uint64_t> levelBits, zeroBits;
+    bool logChanges = false;
+    unsigned clockTicks = 0, examined = 0;
+    Clock::time_point activeDeadline = Clock::time_point::max();
+
+    BasicLocalSearch() = default;
+    explicit BasicLocalSearch(const Graph &g, const std::vector<double> *w = nullptr) { reset(g, w); }
+
+    // Empty solution over g; buffers keep their capacity, so one object can serve many runs.
+    // w (one weight per vertex, or null) must outlive the run.
+    void reset(const Graph &g, const std::vector<double> *w = nullptr) {
+        adj = &g;
+        weights = w;
+        size = 0;
+        totalWeight = 0;
+        isSelected.assign(g.size(), 0);
+        members.clear();
+        position.resize(g.size());
+        solCount.assign(g.size(), 0);
+        queued.assign(g.size(), 0);
+        localIndex.assign(g.size(), -1);
+        freeList.clear();
+        dirty.clear();
+        timedOut = false;
+        moves = 0;
+        tally.clear();
+    }
+
+    void markDirty(int u) {
+        if (!queued[u]) { queued[u] = 1; dirty.push_back(u); }
+    }
+
+    double weight(int v) const { return weights ? (*weights)[v] : 1.0; }
+
+    // The only selected neighbor of a 1-tight rectangle
+    int soleSelectedNeighbor(int w) const {
+        for (const int *p = adj->begin(w); p != adj->end(w); ++p)
+            if (isSelected[*p]) return *p;
+        return -1;
+    }
+
+    void insert(int v) {
+        isSelected[v] = 1;
+        position[v] = (int)members.size();
+        members.push_back(v);
+        ++size;
+        totalWeight += weight(v);
+        markDirty(v);
+        if (logChanges) changeLog.push_back(v);
+        for (const int *p = adj->begin(v); p != adj->end(v); ++p) ++solCount[*p];
+    }
+
+    // Queues the moves that the unselected rectangle w may now take part in
+    void requeue(int w) {
+        if (solCount[w] == 0) freeList.push_back(w);
+        else if (solCount[w] == 1) markDirty(soleSelectedNeighbor(w));
+        else if (solCount[w] == 2 && weights) markDirty(soleSelectedNeighbor(w));   // new (2,1) candidate
+    }
+
+    void remove(int u) {
+        isSelected[u] = 0;
+        const int last = members.back();
+        members[position[u]] = last;
+        position[last] = position[u];
+        members.pop_back();
+        --size;
+        totalWeight -= weight(u);
+        if (logChanges) changeLog.push_back(u);
+        for (const int *p = adj->begin(u); p != adj->end(u); ++p) {
+            int w = *p;
+            --solCount[w];
+            if (!isSelected[w]) requeue(w);
+        }
+        requeue(u);
+    }
+
+    // Vertex v was just added to the graph with its edges: count its selected neighbors and queue
+    // the moves it enables. repair() then restores the local optimum.
+    void attach(int v) {
+        const size_t n = adj->size();
+        isSelected.resize(n, 0);
+        position.resize(n);
+        solCount.resize(n, 0);
+        queued.resize(n, 0);
+        localIndex.resize(n, -1);
+        solCount[v] = 0;
+        for (const int *p = adj->begin(v); p != adj->end(v); ++p) solCount[v] += isSelected[*p];
+        requeue(v);
+    }
+
+    // Vertex v is about to lose its edges: drop it from the solution (queueing the moves this
+    // frees) and from the pending insertions, so it is never selected again
+    void detach(int v) {
+        if (isSelected[v]) remove(v);
+        freeList.erase(std::remove(freeList.begin(), freeList.end(), v), freeList.end());
+    }
+
+    // (0,1) and (1,2) moves (weighted: also (1,1), (2,1)) over what attach / detach queued
+    void repair() {
+        activeDeadline = deadline;
+        fillFree();
+        descend();
+    }
+
+    // (0,1) moves: insert every rectangle left without a selected neighbor (of positive weight)
+    void fillFree() {
+        while (!freeList.empty()) {
+            int v = freeList.back();
+            freeList.pop_back();
+            tally.add(CTR_TRIED_0_1);
+            if (!isSelected[v] && solCount[v] == 0 && weight(v) > 0) { insert(v); ++moves; tally.add(CTR_APPLIED_0_1); }
+        }
+    }
+
+    // (1,2) move around u: two non-overlapping rectangles whose only selected neighbor is u.
+    // Candidates get local indices; row i of `conflictBits` marks the candidates overlapping
+    // candidate i, so a partner for i is the first bit of (all & ~row_i) above i.
+    bool trySwap(int u) {
+        if (weights) return tryWeightedSwap(u);
+        tally.add(CTR_TRIED_1_2);
+        std::vector<int> &cand = candidates;
+        cand.clear();
+        for (const int *p = adj->begin(u); p != adj->end(u); ++p)
+            if (!isSelected[*p] && solCount[*p] == 1) cand.push_back(*p);
+        const int k = (int)cand.size();
+        if (k < 2) return false;
+
+        const int words = bitWords(k);
+        allBits.assign(words, 0);
+        conflictBits.assign((size_t)k * words, 0);
+        for (int i = 0; i < k; ++i) { localIndex[cand[i]] = i; setBit(allBits.data(), i); }
+        for (int i = 0; i < k; ++i)
+            for (const int *p = adj->begin(cand[i]); p != adj->end(cand[i]); ++p)
+                if (localIndex[*p] >= 0) setBit(&conflictBits[(size_t)i * words], localIndex[*p]);
+
+        int c1 = -1, c2 = -1;
+        for (int i = 0; i + 1 < k && c1 < 0; ++i) {
+            int j = firstAndNot(allBits.data(), &conflictBits[(size_t)i * words], words, i + 1);
+            if (j >= 0) { c1 = cand[i]; c2 = cand[j]; }
+        }
+        for (int v : cand) localIndex[v] = -1;
+        if (c1 < 0) return false;
+
+        remove(u);
+        insert(c1);
+        insert(c2);
+        tally.add(CTR_APPLIED_1_2);
+        return true;
+    }
+
+    // Weighted moves around u, applied if they gain weight:
+    //   (2,1) a neighbor v with exactly two selected neighbors u, x and w(v) > w(u) + w(x);
+    //   (1,2) two non-overlapping 1-tight neighbors with w(a) + w(b) > w(u);
+    //   (1,1) a 1-tight neighbor heavier than u.
+    // Neighbors of weight <= 0 are never candidates.
+    // The 1-tight candidates are sorted by decreasing weight before they get local indices, so
+    // the first partner bit above i is the heaviest partner lighter than candidate i.
+    bool tryWeightedSwap(int u) {
+        const double wu = weight(u);
+        std::vector<int> &cand = candidates;
+        cand.clear();
+        for (const int *p = adj->begin(u); p != adj->end(u); ++p) {
+            const int v = *p;
+            if (isSelected[v] || weight(v) <= 0) continue;
+            if (solCount[v] == 1) { cand.push_back(v); continue; }
+            if (solCount[v] != 2) continue;
+            int x = -1;
+            for (const int *q = adj->begin(v); q != adj->end(v) && x < 0; ++q)
+                if (*q != u && isSelected[*q]) x = *q;
+            tally.add(CTR_TRIED_2_1);
+            if (weight(v) > wu + weight(x)) {
+                remove(u);
+                remove(x);
+                insert(v);
+                tally.add(CTR_APPLIED_2_1);
+                return true;
+            }
+        }
+        const int k = (int)cand.size();
+        if (k == 0) return false;
+        std::sort(cand.begin(), cand.end(), [&](int a, int b) {
+            return weight(a) != weight(b) ? weight(a) > weight(b) : a < b;
+        });
+
+        int c1 = -1, c2 = -1;
+        if (k >= 2 && weight(cand[0]) + weight(cand[1]) > wu) {
+            tally.add(CTR_TRIED_1_2);
+            const int words = bitWords(k);
+            allBits.assign(words, 0);
+            conflictBits.assign((size_t)k * words, 0);
+            for (int i = 0; i < k; ++i) { localIndex[cand[i]] = i; setBit(allBits.data(), i); }
+            for (int i = 0; i < k; ++i)
+                for (const int *p = adj->begin(cand[i]); p != adj->end(cand[i]); ++p)
+                    if (localIndex[*p] >= 0) setBit(&conflictBits[(size_t)i * words], localIndex[*p]);
+
+            for (int i = 0; i + 1 < k && c1 < 0 && weight(cand[i]) + weight(cand[i + 1]) > wu; ++i) {
+                int j = firstAndNot(allBits.data(), &conflictBits[(size_t)i * words], words, i + 1);
+                if (j >= 0 && weight(cand[i]) + weight(cand[j]) > wu) { c1 = cand[i]; c2 = cand[j]; }
+            }
+            for (int v : cand) localIndex[v] = -1;
+        }
+        if (c1 < 0) {
+            tally.add(CTR_TRIED_1_1);
+            if (weight(cand[0]) > wu) c1 = cand[0];
+        }
+        if (c1 < 0) return false;
+
+        remove(u);
+        insert(c1);
+        if (c2 >= 0) insert(c2);
+        tally.add(c2 >= 0 ? CTR_APPLIED_1_2 : CTR_APPLIED_1_1);
+        return true;
+    }
+
+    // Applies (0,1) and (1,2) moves (weighted: also (1,1), (2,1)) until none is left
+    void descend() {
+        while (!dirty.empty() && !expired()) {
+            int u = dirty.back();
+            dirty.pop_back();
+            queued[u] = 0;
+            tick();
+            if (isSelected[u] && trySwap(u)) { ++moves; fillFree(); }
+        }
+    }
+
+    // Checks the active deadline every 64 calls
+    bool expired() {
+        if (!timedOut && (++clockTicks & 63) == 0 && Clock::now() >= activeDeadline) timedOut = true;
+        return timedOut;
+    }
+
+    void tick() {
+        if (progress && (++examined & 255) == 0) progress(*this);
+    }
+
+    void queueK(int u) {
+        if (!kQueued[u]) { kQueued[u] = 1; kQueue.push_back(u); }
+    }
+
+    // Selected rectangles sharing a candidate (an unselected neighbor with at most maxK selected
+    // neighbors) with the selected rectangle s
+    void solutionNeighbors(int s, std::vector<int> &out) {
+        out.clear();
+        for (const int *p = adj->begin(s); p != adj->end(s); ++p) {
+            const int v = *p;
+            if (isSelected[v] || solCount[v] > maxK || solCount[v] < 2) continue;
+            for (const int *q = adj->begin(v); q != adj->end(v); ++q)
+                if (*q != s && isSelected[*q] && hits[*q] == 0) { hits[*q] = 1; out.push_back(*q); }
+        }
+        for (int x : out) hits[x] = 0;
+    }
+
+    // Independent candidates (local indices, sorted by decreasing weight) extending chosen[0..depth)
+    // whose total weight exceeds target, at most maxSize of them. Level d of levelBits holds the
+    // candidates compatible with the first d choices.
+    bool findInsertion(int depth, double gained, double target, int maxSize, int words, int from) {
+        const uint64_t *allowed = &levelBits[(size_t)depth * words];
+        if (!weights) {   // unweighted: enough compatible candidates must be left
+            int left = 0;
+            for (int w = from >> 6; w < words; ++w)
+                left += __builtin_popcountll(w == (from >> 6) ? allowed[w] & (~uint64_t(0) << (from & 63)) : allowed[w]);
+            if (left < maxSize - depth) return false;
+        }
+        for (int i = firstAndNot(allowed, zeroBits.data(), words, from); i >= 0;
+             i = firstAndNot(allowed, zeroBits.data(), words, i + 1)) {
+            const double wi = weight(candidates[i]);
+            if (gained + (maxSize - depth) * wi <= target) return false;   // later candidates are lighter
+            chosen[depth] = i;
+            if (gained + wi > target) { chosen.resize(depth + 1); return true; }
+            if (depth + 1 == maxSize) continue;
+            uint64_t *next = &levelBits[(size_t)(depth + 1) * words];
+            const uint64_t *row = &conflictBits[(size_t)i * words];
+            for (int w = 0; w < words; ++w) next[w] = allowed[w] & ~row[w];
+            if (findInsertion(depth + 1, gained + wi, target, maxSize, words, i + 1)) return true;
+        }
+        return false;
+    }
+
+    // Replaces the selected rectangles in `removal` by |removal| + 1 candidates (weighted: by up to
+    // that many, of larger total weight) if such an insertion set exists
+    bool tryRemoval() {
+        if (expired()) return false;
+        tally.add(CTR_TRIED_K);
+        const int j = (int)removal.size();
+        double removedWeight = 0;
+        touched.clear();
+        for (int s : removal) {
+            removedWeight += weight(s);
+            for (const int *p = adj->begin(s); p != adj->end(s); ++p)
+                if (!isSelected[*p] && solCount[*p] <= j && hits[*p]++ == 0) touched.push_back(*p);
+        }
+        std::vector<int> &cand = candidates;
+        cand.clear();
+        for (int v : touched) {
+            if (hits[v] == solCount[v] && weight(v) > 0) cand.push_back(v);
+            hits[v] = 0;
+        }
+        const int k = (int)cand.size();
+        if (k > KSWAP_MAX_CANDIDATES || (weights ? k == 0 : k <= j)) return false;
+        if (weights)
+            std::sort(cand.begin(), cand.end(), [&](int a, int b) {
+                return weight(a) != weight(b) ? weight(a) > weight(b) : a < b;
+            });
+
+        const int words = bitWords(k);
+        zeroBits.assign(words, 0);
+        levelBits.assign((size_t)(j + 1) * words, 0);
+        conflictBits.assign((size_t)k * words, 0);
+        for (int i = 0; i < k; ++i) { localIndex[cand[i]] = i; setBit(levelBits.data(), i); }
+        for (int i = 0; i < k; ++i)
+            for (const int *p = adj->begin(cand[i]); p != adj->end(cand[i]); ++p)
+                if (localIndex[*p] >= 0) setBit(&conflictBits[(size_t)i * words], localIndex[*p]);
+        chosen.assign(j + 1, -1);
+        const bool found = findInsertion(0, 0.0, removedWeight, j + 1, words, 0);
+        for (int v : cand) localIndex[v] = -1;
+        if (!found) return false;
+
+        for (int s : removal) remove(s);
+        for (int i : chosen) insert(cand[i]);
+        tally.add(CTR_APPLIED_K);
+        return true;
+    }
+
+    // (k, k+1) moves around u for k = 2..maxK over connected removal sets containing u. Sets of
+    // three are {u, a, b} with a, b both next to u (a before b), or a path u - a - b.
+    bool tryKSwap(int u) {
+        solutionNeighbors(u, nearU);
+        for (int a : nearU) {
+            removal.assign({u, a});
+            if (tryRemoval()) return true;
+        }
+        if (maxK < 3) return false;
+        for (size_t a = 0; a < nearU.size(); ++a)
+            for (size_t b = a + 1; b < nearU.size(); ++b) {
+                removal.assign({u, nearU[a], nearU[b]});
+                if (tryRemoval()) return true;
+            }
+        for (int a : nearU) {
+            solutionNeighbors(a, nearA);
+            for (int b : nearA) {
+                if (b == u || std::find(nearU.begin(), nearU.end(), b) != nearU.end()) continue;
+                removal.assign({u, a, b});
+                if (tryRemoval()) return true;
+            }
+        }
+        return false;
+    }
+
+    // Queues every solution member within two conflict-graph steps of a changed rectangle
+    void requeueChanged() {
+        for (int x : changeLog) {
+            if (isSelected[x]) queueK(x);
+            for (const int *p = adj->begin(x); p != adj->end(x); ++p) {
+                if (isSelected[*p]) { queueK(*p); continue; }
+                for (const int *q = adj->begin(*p); q != adj->end(*p); ++q)
+                    if (isSelected[*q]) queueK(*q);
+            }
+        }
+        changeLog.clear();
+    }
+
+    // (k, k+1) phase on a (1,2)-optimal solution, until no move is left or the deadline passes.
+    // The descent after each move answers to `deadline` only, so stopping at `swapDeadline`
+    // still leaves a (1,2)-optimal solution.
+    void improveK() {
+        hits.assign(adj->size(), 0);
+        kQueued.assign(adj->size(), 0);
+        kQueue.clear();
+        for (int v = adj->size() - 1; v >= 0; --v)
+            if (isSelected[v]) queueK(v);
+
+        logChanges = true;
+        activeDeadline = std::min(deadline, swapDeadline);
+        while (!kQueue.empty() && !expired()) {
+            const int u = kQueue.back();
+            kQueue.pop_back();
+            kQueued[u] = 0;
+            tick();
+            if (!isSelected[u] || !tryKSwap(u)) continue;
+            ++moves;
+            fillFree();
+            activeDeadline = deadline;
+            descend();
+            activeDeadline = std::min(deadline, swapDeadline);
+            requeueChanged();
+        }
+        logChanges = false;
+        changeLog.clear();
+    }
+
+    // Takes a solution that already is a local optimum (e.g. what run() returned on the same
+    // graph): sets up the counts and the indexed set without queueing any move
+    void adopt(const std::vector<int> &solution) {
+        for (int v : solution) insert(v);
+        for (int u : dirty) queued[u] = 0;
+        dirty.clear();
+    }
+
+    // Descends from the given solution to a local optimum
+    void run(const std::vector<int> &initial) {
+        for (int v : initial) insert(v);
+        for (int v = 0; v < adj->size(); ++v)
+            if (!isSelected[v] && solCount[v] == 0) freeList.push_back(v);
+        activeDeadline = deadline;
+        fillFree();
+        descend();
+        if (maxK > 1 && !timedOut) improveK();
+    }
+
+    // The solution, sorted
+    std::vector<int> solution() const {
+        std::vector<int> sol(members);
+        std::sort(sol.begin(), sol.end());
+        return sol;
+    }
+};
+
+using LocalSearch = BasicLocalSearch<>;
+
+#endif // MISR_LOCAL_SEARCH_H
@@ -0,0 +1,489 @@
+/*
+ * Local search solver library (see localsearch.cpp for the CLI).
+ *
+ * solve_local returns a local optimum of an Instance (misr.h) under (0,1), (1,2) and optionally
+ * (k, k+1) swaps (local_search.h): greedy start, decomposition into conflict-graph components,
+ * independent restarts from perturbed greedy orders on a thread pool, best restart kept per
+ * component. Weighted instances maximize the total weight.
+ *
+ * StripSolver streams an instance sorted by x1 through solve_local window by window, and
+ * DynamicSolver keeps a solution up to date while rectangles are inserted and erased.
+ */
+
+#ifndef MISR_LOCAL_SOLVER_H
+#define MISR_LOCAL_SOLVER_H
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <random>
+#include <unordered_map>
+#include <vector>
+#include "conflict_graph.h"
+#include "counters.h"
+#include "local_search.h"
+#include "misr.h"
+#include "parallel.h"
+#include "phase_times.h"
+#include "time_budget.h"
+
+namespace local_solver {
+
+using namespace std;
+
+
+struct Options {
+    int threads = 0;          // 0 = one per hardware thread
+    int restarts = 1;         // independent descents; restart 0 is the plain x2 greedy
+    uint64_t seed = 1;        // restart r uses seed + r, independent of the thread count
+    GreedyStrategy strategy = GreedyStrategy::RightEdge;
+    bool strategySet = false; // --greedy given; otherwise weighted instances use WeightPerConflict
+    bool decompose = true;    // solve connected components separately
+    int k = 1;                // largest removal set of the swap moves (1, 2 or 3)
+    double swapTime = -1;     // seconds for the (k, k+1) phase, < 0 = unlimited
+    double timeLimit = -1;    // seconds for the whole instance, < 0 = unlimited
+    double progressEvery = 0; // seconds between progress lines, 0 = none
+    bool timePhases = false;  // fill SolveStats::phaseSeconds
+};
+
+// Buffers of one worker's descents: the component's rectangles, weights and induced graph, the
+// greedy order and start. They keep their capacity, so tasks allocate nothing once warm.
+struct TaskScratch {
+    vector<InstanceRect> rects;
+    vector<double> weights;
+    ConflictGraph adj;
+    vector<int> order, initial;
+    GreedyScratch greedy;
+};
+
+// Buffers kept across instances in --batch mode
+struct Workspace {
+    ConflictGraphBuilder builder;
+    ConflictGraph adj;
+    vector<int> compOffsets, compMembers;   // components in CSR form (connectedComponents)
+    vector<LocalSearch> searches;   // one per worker thread
+    vector<TaskScratch> scratch;    // one per worker thread
+    bool timedOut = false;          // the last instance stopped at --time-limit
+    PhaseTimes *phases = nullptr;   // per-phase timings (phase_times.h), if wanted
+    Counters *counters = nullptr;   // event counts (counters.h), if wanted
+};
+
+// Returns the selected rectangle ids, sorted. The conflict graph is built on the instance's ranks;
+// the greedy orders read the original coordinates.
+inline vector<int> solveInstance(const Instance& inst, const Options& opts, Workspace& ws) {
+    const TimeBudget budget(opts.timeLimit), swapBudget(opts.swapTime);
+    Progress progress(budget, opts.progressEvery);
+
+    // --- Precompute Conflicts ---
+    PhaseTimer timer(ws.phases, PHASE_GRAPH);
+    const int n = inst.size();
+    ConflictGraph &adj = ws.adj;
+    ws.builder.build(inst.ranks, adj);
+    if (ws.counters) ws.counters->add(CTR_CONFLICT_EDGES, adj.edgeCount());
+
+    const bool weighted = inst.weighted;
+    const GreedyStrategy strategy = weighted && !opts.strategySet ? GreedyStrategy::WeightPerConflict : opts.strategy;
+
+    // --- Decompose: components are independent, isolated rectangles are always selected ---
+    vector<int> &offsets = ws.compOffsets, &members = ws.compMembers;
+    if (opts.decompose) {
+        connectedComponents(adj, offsets, members);
+    } else {
+        offsets.assign({0, n});
+        if (n == 0) offsets.resize(1);
+        members.resize(n);
+        for (int i = 0; i < n; ++i) members[i] = i;
+    }
+    vector<int> currentSol;
+    vector<int> parts;   // components with two or more members
+    for (size_t c = 0; c + 1 < offsets.size(); ++c) {
+        if (offsets[c + 1] - offsets[c] > 1) parts.push_back((int)c);
+        else if (inst.weights[members[offsets[c]]] > 0) currentSol.push_back(members[offsets[c]]);
+    }
+    // Largest first, so the big components start early and the small ones fill in
+    auto partSize = [&](int c) { return offsets[c + 1] - offsets[c]; };
+    stable_sort(parts.begin(), parts.end(), [&](int a, int b) { return partSize(a) > partSize(b); });
+
+    // --- K descents per component: 1. greedy start, 2./3. (0,1) insertions and (1,2) swaps ---
+    // All (component, restart) pairs share one pool. A task copies its component into the
+    // worker's scratch (restarts of a component repeat that copy, which costs far less than the
+    // descent) and the best restart of every component is written into `best`, which holds each
+    // component's members at the component's offset.
+    timer.stop();
+    const size_t restarts = opts.restarts;
+    const size_t tasks = parts.size() * restarts;
+    ws.searches.resize(opts.threads);
+    ws.scratch.resize(opts.threads);
+    vector<int> best(n);
+    vector<int> bestCount(parts.size(), 0);
+    vector<double> bestValue(parts.size(), -HUGE_VAL);   // total weight (the size when unweighted)
+    vector<size_t> bestRestart(parts.size(), restarts);
+    mutex bestMutex;
+
+    // Progress lines: best = isolated rectangles + the best finished descent of every component
+    atomic<double> finishedBest{0.0};
+    atomic<uint64_t> finishedMoves{0};
+    for (int id : currentSol) finishedBest = finishedBest + inst.weights[id];
+
+    parallelForWorker(tasks, opts.threads, [&](size_t t, int worker) {
+        const size_t p = t / restarts, r = t % restarts;
+        const int c = parts[p];
+        const int *mem = &members[offsets[c]];
+        const size_t k = partSize(c);
+        PhaseTimer taskTimer(ws.phases, PHASE_INIT);
+        TaskScratch &s = ws.scratch[worker];
+        s.rects.clear();
+        for (size_t i = 0; i < k; ++i) s.rects.push_back(inst.rects[mem[i]]);
+        s.weights.clear();
+        if (weighted) for (size_t i = 0; i < k; ++i) s.weights.push_back(inst.weights[mem[i]]);
+        if (opts.decompose) inducedSubgraph(adj, mem, k, s.adj);
+        const ConflictGraph &g = opts.decompose ? s.adj : adj;   // not split: members are 0..n-1
+
+        mt19937_64 rng(opts.seed + r);
+        const vector<double> *weights = weighted ? &s.weights : nullptr;
+        greedyOrderInto(s.order, s.greedy, s.rects, g, strategy, r == 0 ? 0.0 : 1.0, &rng, weights);
+        if (strategy == GreedyStrategy::RightEdge && r == 0) greedySweepInto(s.initial, s.greedy, s.rects, s.order, weights);
+        else greedyInitInto(s.initial, s.greedy, g, s.order, weights);
+        LocalSearch &search = ws.searches[worker];
+        search.reset(g, weights);
+        search.maxK = opts.k;
+        search.deadline = budget.deadline;
+        search.swapDeadline = swapBudget.deadline;
+        search.progress = nullptr;
+        if (progress.enabled())
+            search.progress = [&](const LocalSearch &ls) { progress.report(finishedBest, finishedMoves + ls.moves, "moves"); };
+        taskTimer.next(PHASE_SEARCH);
+        search.run(s.initial);
+        taskTimer.stop();
+        if (ws.counters) ws.counters->add(search.tally);
+
+        // Ties go to the lowest restart, so the answer does not depend on threads
+        lock_guard<mutex> lock(bestMutex);
+        const double value = search.totalWeight;
+        if (value > bestValue[p] || (value == bestValue[p] && r < bestRestart[p])) {
+            if (progress.enabled()) finishedBest = finishedBest + (value - max(bestValue[p], 0.0));
+            bestValue[p] = value;
+            bestRestart[p] = r;
+            bestCount[p] = (int)search.members.size();
+            for (size_t i = 0; i < search.members.size(); ++i) best[offsets[c] + i] = mem[search.members[i]];
+        }
+        if (progress.enabled()) {
+            finishedMoves += search.moves;
+            progress.report(finishedBest, finishedMoves, "moves");
+        }
+    });
+
+    PhaseTimer reconstruct(ws.phases, PHASE_RECONSTRUCT);
+    for (size_t p = 0; p < parts.size(); ++p)
+        currentSol.insert(currentSol.end(), best.begin() + offsets[parts[p]], best.begin() + offsets[parts[p]] + bestCount[p]);
+    ws.timedOut = budget.expired();
+    sort(currentSol.begin(), currentSol.end());
+    return currentSol;
+}
+
+} // namespace local_solver
+
+// Solves inst; ws keeps the conflict graph and the per-thread searches across calls, as --batch
+// does. Without it a temporary workspace is used.
+inline Solution solve_local(const Instance &inst, const local_solver::Options &opts = {}, local_solver::Workspace *ws = nullptr) {
+    using namespace local_solver;
+    const TimeBudget clock;
+    PhaseTimes times;
+    Counters counters;
+    Workspace scratch;
+    if (!ws) ws = &scratch;
+    ws->phases = opts.timePhases ? &times : nullptr;
+    ws->counters = &counters;
+
+    Options resolved = opts;
+    resolved.threads = resolveThreads(opts.threads);
+    Solution sol;
+    sol.selected = solveInstance(inst, resolved, *ws);
+    ws->phases = nullptr;
+    ws->counters = nullptr;
+    sol.stats.value = inst.totalWeight(sol.selected);
+    sol.stats.timedOut = ws->timedOut;
+    sol.stats.seconds = clock.elapsed();
+    for (int p = 0; p < PHASE_COUNT; ++p) sol.stats.phaseSeconds[p] = times.seconds(p);
+    counters.copyTo(sol.stats.counters);
+    return sol;
+}
+
+namespace local_solver {
+
+// Streaming solve (--stream) of an instance whose rectangles arrive sorted by x1, in memory
+// proportional to a strip instead of the whole instance.
+//
+// The window holds the rectangles not decided yet. Every `strip` pushes it is solved with
+// solve_local, and the frontier is the x1 of the last push: no later rectangle starts left of
+// it, so one that ends at or before it ("closed") can never conflict with anything still to
+// come. Closed rectangles without an open neighbor are committed with the window's answer; the
+// open ones and their closed neighbors are carried into the next window, where the boundary is
+// re-solved with the new rectangles. A carried rectangle adjacent to a committed selected one
+// was unselected and can never be selected again, so it is dropped.
+//
+// Memory is the window plus 4 bytes per selected rectangle. The window stays near `strip`
+// unless many rectangles span a long x range, since those stay open for several rounds.
+class StripSolver {
+public:
+    StripSolver(const Options &opts, size_t strip)
+        : opts(opts), strip(max<size_t>(strip, 1)), budget(opts.timeLimit), progress(budget, opts.progressEvery) {
+        this->opts.progressEvery = 0;   // one progress line for the stream, not one per window
+    }
+
+    // Adds rectangle `id`. False, and nothing changes, when it starts left of the previous one.
+    bool push(int id, const InstanceRect &r, double w) {
+        if (!ids.empty() && r.x1 < lastX1) return false;
+        lastX1 = r.x1;
+        ids.push_back(id);
+        rects.push_back(r);
+        weights.push_back(w);
+        ++pushed;
+        if (++fresh >= strip) flush(lastX1);
+        return true;
+    }
+
+    // Solves what is left of the window; the selection and stats are then complete. With phase
+    // timings, the time spent outside the windows (reading the stream) counts as parse.
+    Solution finish() {
+        if (!ids.empty()) flush(HUGE_VAL);
+        Solution sol;
+        sol.selected = move(chosen);
+        sort(sol.selected.begin(), sol.selected.end());
+        sol.stats = stats;
+        sol.stats.seconds = budget.elapsed();
+        if (opts.timePhases) sol.stats.phaseSeconds[PHASE_PARSE] = max(0.0, sol.stats.seconds - windowSeconds);
+        return sol;
+    }
+
+    size_t largestWindow = 0;   // most rectangles solved at once
+
+private:
+    Options opts;
+    const size_t strip;
+    const TimeBudget budget;
+    Progress progress;
+    Workspace ws;
+    vector<int> ids;              // window: global ids, rectangles and weights
+    vector<InstanceRect> rects;
+    vector<double> weights;
+    vector<int> chosen;           // committed selection
+    vector<char> state;           // per window rectangle, see flush
+    double lastX1 = -HUGE_VAL;
+    size_t fresh = 0;             // pushes since the last flush
+    uint64_t pushed = 0;
+    SolveStats stats;
+    double windowSeconds = 0;     // wall time inside flush
+
+    void flush(double frontier) {
+        const TimeBudget clock;
+        const size_t n = ids.size();
+        largestWindow = max(largestWindow, n);
+        fresh = 0;
+        Instance inst;
+        inst.rects.swap(rects);
+        inst.weights.swap(weights);
+        inst.compress();
+        if (opts.timePhases) stats.phaseSeconds[PHASE_COMPRESS] += clock.elapsed();
+        Options round = opts;
+        if (budget.limited()) round.timeLimit = max(0.0, budget.remaining());
+        const Solution sol = solve_local(inst, round, &ws);
+        accumulate(sol.stats);
+        const ConflictGraph &adj = ws.adj;   // the window's graph, left by solve_local
+
+        // 0 = commit, 1 = carry; selected marks go in bit 1
+        enum { CARRY = 1, SELECTED = 2 };
+        state.assign(n, 0);
+        for (int i : sol.selected) state[i] = SELECTED;
+        for (size_t i = 0; i < n; ++i) {
+            if (inst.rects[i].x2 <= frontier) continue;
+            state[i] |= CARRY;
+            for (const int *j = adj.begin((int)i); j != adj.end((int)i); ++j) state[*j] |= CARRY;
+        }
+        size_t kept = 0;
+        for (size_t i = 0; i < n; ++i) {
+            if (!(state[i] & CARRY)) {
+                if (state[i] & SELECTED) { chosen.push_back(ids[i]); stats.value += inst.weights[i]; }
+                continue;
+            }
+            bool blocked = false;
+            for (const int *j = adj.begin((int)i); j != adj.end((int)i) && !blocked; ++j)
+                blocked = state[*j] == SELECTED;
+            if (blocked) continue;
+            ids[kept] = ids[i];
+            inst.rects[kept] = inst.rects[i];
+            inst.weights[kept] = inst.weights[i];
+            ++kept;
+        }
+        ids.resize(kept);
+        inst.rects.resize(kept);
+        inst.weights.resize(kept);
+        rects.swap(inst.rects);
+        weights.swap(inst.weights);
+        windowSeconds += clock.elapsed();
+        progress.report(stats.value, pushed, "rects");
+    }
+
+    void accumulate(const SolveStats &s) {
+        stats.timedOut |= s.timedOut;
+        for (int p = 0; p < PHASE_COUNT; ++p) stats.phaseSeconds[p] += s.phaseSeconds[p];
+        for (int c = 0; c < CTR_COUNT; ++c) stats.counters[c] += s.counters[c];
+    }
+};
+
+// Incremental solve (--updates) of an instance that changes a few rectangles at a time.
+//
+// The constructor solves the instance with solve_local and keeps its conflict graph as
+// adjacency lists, plus a hash grid over the original coordinates with cells the size of the
+// initial instance's median rectangle. As in ConflictGraphBuilder, a rectangle covering more than
+// max(16, ids / 16) cells is not put in the grid: it goes to a list of large rectangles, which
+// every insert() tests directly, and an inserted large rectangle is tested against all live ones.
+// insert() finds the new rectangle's neighbors that way and erase() drops a rectangle's edges
+// (and its grid cells once they are empty); both then repair the solution with (0,1) and (1,2)
+// moves (weighted: also (1,1) and (2,1)) queued only around the change, so an update costs about
+// the degrees and grid cells it touches plus the large rectangles, not n. The result is a local
+// optimum under those moves; the (k, k+1) moves of --k run in the initial solve only.
+//
+// Ids are stable: the instance keeps 0..n-1, insertions continue from n, and erased ids are not
+// reused (they keep a few bytes each).
+class DynamicSolver {
+public:
+    explicit DynamicSolver(const Instance &inst, const Options &opts = {})
+        : rects(inst.rects), weights(inst.weights), alive(inst.size(), 1), isLarge(inst.size(), 0),
+          seen(inst.size(), 0) {
+        Workspace ws;
+        const Solution sol = solve_local(inst, opts, &ws);
+        initial = sol.stats;
+        graph = DynamicConflictGraph(ws.adj);
+
+        // Median side lengths, so a few huge rectangles do not blow up the cells
+        const int n = inst.size();
+        vector<double> extent(n);
+        auto median = [&](auto side) {
+            if (n == 0) return 1.0;
+            for (int i = 0; i < n; ++i) extent[i] = side(rects[i]);
+            nth_element(extent.begin(), extent.begin() + n / 2, extent.end());
+            return extent[n / 2];
+        };
+        cellW = median([](const InstanceRect &r) { return r.x2 - r.x1; });
+        cellH = median([](const InstanceRect &r) { return r.y2 - r.y1; });
+        for (int i = 0; i < n; ++i) place(i);
+
+        // solve_local's answer is already a local optimum, so only the counts are set up; a
+        // solve stopped at --time-limit is descended from instead
+        search.reset(graph, inst.weighted ? &weights : nullptr);
+        if (sol.stats.timedOut) search.run(sol.selected);
+        else search.adopt(sol.selected);
+    }
+
+    // Adds a rectangle (x1 < x2, y1 < y2) and returns its id
+    int insert(const InstanceRect &r, double w = 1.0) {
+        if (w != 1.0) search.weights = &weights;   // from now on the moves compare weights
+        neighbors.clear();
+        auto test = [&](int j) {
+            const InstanceRect &o = rects[j];
+            if (r.x1 < o.x2 && o.x1 < r.x2 && r.y1 < o.y2 && o.y1 < r.y2) neighbors.push_back(j);
+        };
+        if (large(r)) {
+            for (int j = 0; j < graph.size(); ++j)
+                if (alive[j]) test(j);
+        } else {
+            ++epoch;
+            forCells(r, [&](uint64_t key) {
+                auto cell = cells.find(key);
+                if (cell == cells.end()) return;
+                for (int j : cell->second) {
+                    if (seen[j] == epoch) continue;
+                    seen[j] = epoch;
+                    test(j);
+                }
+            });
+            for (int j : larges) test(j);
+        }
+        const int id = graph.addVertex(neighbors);
+        rects.push_back(r);
+        weights.push_back(w);
+        alive.push_back(1);
+        isLarge.push_back(0);
+        seen.push_back(0);
+        place(id);
+        search.attach(id);
+        search.repair();
+        return id;
+    }
+
+    // Removes rectangle id; false if there is no such (live) rectangle
+    bool erase(int id) {
+        if (id < 0 || id >= graph.size() || !alive[id]) return false;
+        search.detach(id);
+        graph.isolate(id);
+        alive[id] = 0;
+        if (isLarge[id]) {
+            *find(larges.begin(), larges.end(), id) = larges.back();
+            larges.pop_back();
+        } else {
+            forCells(rects[id], [&](uint64_t key) {
+                auto cell = cells.find(key);
+                vector<int> &ids = cell->second;
+                *find(ids.begin(), ids.end(), id) = ids.back();
+                ids.pop_back();
+                if (ids.empty()) cells.erase(cell);
+            });
+        }
+        search.repair();
+        return true;
+    }
+
+    // Selected ids, sorted (O(|S| log |S|))
+    vector<int> selected() const { return search.solution(); }
+    double value() const { return search.totalWeight; }
+    bool contains(int id) const { return id >= 0 && id < graph.size() && alive[id]; }
+    int size() const { return graph.size(); }   // ids used so far, the next insert's id
+
+    SolveStats initial;         // stats of the initial solve_local
+
+private:
+    vector<InstanceRect> rects;
+    vector<double> weights;
+    vector<char> alive;
+    vector<char> isLarge;         // per id: kept in `larges` instead of the grid
+    DynamicConflictGraph graph;
+    BasicLocalSearch<DynamicConflictGraph> search;
+    unordered_map<uint64_t, vector<int>> cells;
+    vector<int> larges;           // live rectangles too large for the grid
+    double cellW = 1, cellH = 1;
+    vector<int> neighbors;
+    vector<uint32_t> seen;        // per id: epoch of the last insert query that met it
+    uint32_t epoch = 0;
+
+    static int64_t cell(double v, double size) { return (int64_t)floor(v / size); }
+
+    // More cells than testing every id would cost (the threshold of ConflictGraphBuilder)
+    bool large(const InstanceRect &r) const {
+        const double covered = (floor(r.x2 / cellW) - floor(r.x1 / cellW) + 1) *
+                               (floor(r.y2 / cellH) - floor(r.y1 / cellH) + 1);
+        return covered > max(16.0, graph.size() / 16.0);
+    }
+
+    // Puts rectangle id in the grid, or in `larges`
+    void place(int id) {
+        if (large(rects[id])) {
+            isLarge[id] = 1;
+            larges.push_back(id);
+            return;
+        }
+        forCells(rects[id], [&](uint64_t key) { cells[key].push_back(id); });
+    }
+
+    template <class Fn>
+    void forCells(const InstanceRect &r, Fn &&fn) const {
+        const int64_t cx1 = cell(r.x1, cellW), cx2 = cell(r.x2, cellW), cy1 = cell(r.y1, cellH), cy2 = cell(r.y2, cellH);
+        for (int64_t cx = cx1; cx <= cx2; ++cx)
+            for (int64_t cy = cy1; cy <= cy2; ++cy)
+                fn((uint64_t)(uint32_t)cx << 32 | (uint32_t)cy);
+    }
+};
+
+} // namespace local_solver
+
+#endif // MISR_LOCAL_SOLVER_H
@@ -2,179 +2,232 @@
  * MISR - Local Search Approximation (1-swap-2)
  *
  * Algorithm:
- * 1. Initialize with a Greedy solution (earliest finish time heuristic).
+ * 1. Initialize with a Greedy solution (earliest finish time heuristic by default; smallest
+ *    area or fewest conflicts via --greedy).
  * 2. Iteratively search for a "move" that increases the set size:
  * - (0, 1) Move: Add a rectangle that fits without conflict.
  * - (1, 2) Move: Remove 1 rectangle from the solution to add 2 new ones.
  * 3. Repeat until no more improvements can be found.
  *
- * Time Complexity: O(N^3). 
+ * Weighted instances (a fifth number per line) maximize the total weight instead: the greedy
+ * start defaults to the weight / (degree + 1) order, and swaps are applied when they gain weight,
+ * including (1,1) and (2,1) moves (local_search.h).
+ *
+ * For every rectangle we keep the number of selected conflict-graph neighbors, updated
+ * through adj on every insertion/removal. A (0,1) move is then a rectangle with count 0,
+ * and the (1,2) candidates for removing u are u's neighbors with count 1 ("1-tight").
+ * Only solution members whose 1-tight neighborhood changed are re-examined.
+ *
+ * --k 2 or --k 3 adds (k, k+1) moves on top (local_search.h): removal sets of up to k
+ * rectangles connected through shared candidates, insertion sets by bounded-depth search.
+ * --swap-time S limits that phase to S seconds per instance. It stops between two moves and the
+ * descent after each move is not cut short, so the result is still (1,2)-optimal (unless
+ * --time-limit stops that descent first).
+ *
+ * --time-limit S stops every descent after S seconds (per instance) with its current solution,
+ * and --progress S prints a progress line on stderr every S seconds (time_budget.h). --stats
+ * prints the phase times and the moves tried / applied by type as JSON on stderr (counters.h).
+ *
+ * Several descents from perturbed greedy orders can run in parallel (--restarts, --threads);
+ * they share the conflict graph read-only and the largest (heaviest) local optimum is returned.
+ * The instance is first split into connected components of the conflict graph: isolated
+ * rectangles are taken directly and every (component, restart) pair is an independent task.
+ *
+ * --stream S reads rectangles sorted by x1 and solves them strip by strip, about S new
+ * rectangles at a time (StripSolver in local_solver.h), without holding the whole instance:
+ * rectangles left of the sweep frontier are committed, the ones crossing it are re-solved with
+ * the next strip.
+ *
+ * --updates FILE solves the instance, then applies the insertions "+ x1 y1 x2 y2 [weight]" and
+ * deletions "- id" of FILE one line at a time (DynamicSolver in local_solver.h): each update
+ * repairs the solution around the changed rectangle instead of solving again. Inserted
+ * rectangles get the ids n, n+1, ... and the result lists the live ids.
+ *
+ * The solver itself is local_solver.h (solve_local); this file parses the options, reads the
+ * instances and prints the result.
+ *
+ * Time Complexity: O(deg^2) per examined rectangle instead of O(N * |S|) rescans.
  */
 
 #include <iostream>
 #include <vector>
 #include <algorithm>
-#include <set>
+#include <string>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include "local_solver.h"
+#include "misr.h"
 
 using namespace std;
-
-struct Rect {
-    int id;
-    double x1, y1, x2, y2;
-};
-
-bool overlap(const Rect& a, const Rect& b) {
-    if (a.x2 <= b.x1 || b.x2 <= a.x1) return false;
-    if (a.y2 <= b.y1 || b.y2 <= a.y1) return false;
-    return true;
-}
-
-// Generate conflict list
-vector<vector<int>> buildConflictGraph(const vector<Rect>& rects) {
-    int n = rects.size();
-    vector<vector<int>> adj(n);
-    for (int i = 0; i < n; i++) {
-        for (int j = i + 1; j < n; j++) {
-            if (overlap(rects[i], rects[j])) {
-                adj[i].push_back(j);
-                adj[j].push_back(i);
-            }
+using namespace local_solver;
+
+int main(int argc, char** argv) {
+    // --- Options ---
+    Options opts;
+    bool batch = false;       // stream of instances, one result line each
+    bool stats = false;       // one JSON line of SolveStats per instance on stderr
+    long long stream = 0;     // > 0: strip size of the streaming solve
+    const char *updates = nullptr;   // insert / delete lines applied after the solve
+    for (int a = 1; a < argc; ++a) {
+        string arg = argv[a];
+        if (arg == "--threads" && a + 1 < argc) opts.threads = atoi(argv[++a]);
+        else if (arg == "--restarts" && a + 1 < argc) opts.restarts = max(1, atoi(argv[++a]));
+        else if (arg == "--seed" && a + 1 < argc) opts.seed = strtoull(argv[++a], nullptr, 10);
+        else if (arg == "--no-decompose") opts.decompose = false;
+        else if (arg == "--k" && a + 1 < argc) opts.k = atoi(argv[++a]);
+        else if (arg == "--swap-time" && a + 1 < argc) opts.swapTime = atof(argv[++a]);
+        else if (arg == "--time-limit" && a + 1 < argc) opts.timeLimit = atof(argv[++a]);
+        else if (arg == "--progress" && a + 1 < argc) opts.progressEvery = atof(argv[++a]);
+        else if (arg == "--batch") batch = true;
+        else if (arg == "--stream" && a + 1 < argc) stream = atoll(argv[++a]);
+        else if (arg == "--updates" && a + 1 < argc) updates = argv[++a];
+        else if (arg == "--stats") stats = opts.timePhases = true;
+        else if (arg == "--greedy" && a + 1 < argc) {
+            string g = argv[++a];
+            if (g == "x2") opts.strategy = GreedyStrategy::RightEdge;
+            else if (g == "area") opts.strategy = GreedyStrategy::SmallestArea;
+            else if (g == "degree") opts.strategy = GreedyStrategy::FewestConflicts;
+            else if (g == "weight") opts.strategy = GreedyStrategy::WeightPerConflict;
+            else { cerr << "Error: --greedy must be one of x2, area, degree, weight.\n"; return 1; }
+            opts.strategySet = true;
+        }
+        else {
+            cerr << "Usage: " << argv[0] << " [--threads N] [--restarts K] [--seed S] [--greedy x2|area|degree|weight]"
+                    " [--k 1|2|3] [--swap-time S] [--time-limit S] [--progress S]"
+                    " [--no-decompose] [--stream S] [--updates FILE] [--stats] [--batch] < input\n";
+            return 1;
         }
     }
-    return adj;
-}
-
-// Greedy Initialization (Sort by x2)
-vector<int> greedyInit(const vector<Rect>& rects) {
-    vector<int> p(rects.size());
-    for(int i=0; i<rects.size(); ++i) p[i] = i;
-    
-    // Sort indices by right edge
-    sort(p.begin(), p.end(), [&](int a, int b) {
-        return rects[a].x2 < rects[b].x2;
-    });
-
-    vector<int> solution;
-    for (int idx : p) {
-        bool conflict = false;
-        for (int selected : solution) {
-            if (overlap(rects[idx], rects[selected])) {
-                conflict = true;
-                break;
-            }
+    if (opts.k < 1 || opts.k > LOCAL_SEARCH_MAX_K) {
+        cerr << "Error: --k must be 1, 2 or 3.\n";
+        return 1;
+    }
+    if (stream < 0) {
+        cerr << "Error: --stream needs a positive strip size.\n";
+        return 1;
+    }
+    if (updates && (batch || stream)) {
+        cerr << "Error: --updates works on a single instance, without --batch or --stream.\n";
+        return 1;
+    }
+    Workspace ws;
+    InstanceReader in(0);   // stdin
+    Instance inst;
+    PhaseTimes reading;
+    PhaseTimes *readTimes = stats ? &reading : nullptr;
+
+    // --- Streaming: the instance is never stored, so inst only counts and checks weights ---
+    int streamed = 0;
+    bool streamWeighted = false;
+    auto read = [&](Solution &sol) {
+        if (!stream) {
+            int status = readInstance(in, inst, readTimes);
+            if (status == 1) sol = solve_local(inst, opts, &ws);
+            return status;
         }
-        if (!conflict) {
-            solution.push_back(idx);
+        StripSolver strips(opts, (size_t)stream);
+        streamed = 0;
+        streamWeighted = false;
+        int status = streamInstance(in, [&](int id, const InstanceRect &r, double w) {
+            ++streamed;
+            streamWeighted |= w != 1.0;
+            if (strips.push(id, r, w)) return true;
+            fprintf(stderr, "Error: --stream needs rectangles sorted by x1; rectangle %d starts left of its predecessor.\n", id);
+            return false;
+        });
+        if (status == 1) sol = strips.finish();
+        return status;
+    };
+    auto count = [&] { return stream ? streamed : inst.size(); };
+    if (stream) readTimes = nullptr;   // StripSolver times the reading between its windows itself
+
+    // --- Batch mode: one line per instance, the count followed by the selected ids ---
+    if (batch) {
+        ios::sync_with_stdio(false);
+        int status;
+        Solution sol;
+        while ((status = read(sol)) == 1) {
+            if (stats) writeStatsJson(stderr, "local", count(), sol, readTimes);
+            reading.clear();
+            cout << sol.selected.size();
+            for (int id : sol.selected) cout << " " << id;
+            cout << "\n" << flush;
         }
+        return status < 0 ? 1 : 0;
     }
-    return solution;
-}
-
-int main() {
-    // --- Input ---
-    int n;
-    if (!(cin >> n)) return 0;
-
-    vector<Rect> rects(n);
-    for (int i = 0; i < n; i++) {
-        rects[i].id = i;
-        cin >> rects[i].x1 >> rects[i].y1 >> rects[i].x2 >> rects[i].y2;
-    }
-
-    // --- Precompute Conflicts ---
-    vector<vector<int>> adj = buildConflictGraph(rects);
-
-    // --- 1. Initial Solution (Greedy) ---
-    vector<int> currentSol = greedyInit(rects);
-    
-    // Track which rectangles are currently selected
-    vector<bool> isSelected(n, false);
-    for (int id : currentSol) isSelected[id] = true;
-
-    bool improved = true;
-    while (improved) {
-        improved = false;
 
-        // --- 2. Try (0, 1) Insertions ---
-        for (int i = 0; i < n; i++) {
-            if (isSelected[i]) continue;
-
-            bool canAdd = true;
-            for (int solId : currentSol) {
-                if (overlap(rects[i], rects[solId])) {
-                    canAdd = false;
-                    break;
+    // --- Dynamic updates: solve once, then repair after every line of the update file ---
+    if (updates) {
+        int status = readInstance(in, inst, readTimes);
+        if (status == 0) cerr << "Error: first line must be a positive integer n.\n";
+        if (status != 1) return 1;
+        ifstream file(updates);
+        if (!file) { cerr << "Error: cannot open " << updates << ".\n"; return 1; }
+
+        DynamicSolver dynamic(inst, opts);
+        Solution sol;
+        sol.selected = dynamic.selected();
+        sol.stats = dynamic.initial;
+        if (stats) writeStatsJson(stderr, "local", inst.size(), sol, readTimes);
+
+        const TimeBudget clock;
+        bool weighted = inst.weighted;
+        int live = inst.size(), lineNo = 0;
+        for (string line; getline(file, line);) {
+            ++lineNo;
+            istringstream fields(line);
+            char op;
+            if (!(fields >> op) || op == '#') continue;
+            InstanceRect r;
+            double w = 1.0;
+            int id;
+            if (op == '+' && fields >> r.x1 >> r.y1 >> r.x2 >> r.y2) {
+                if (!(fields >> w)) w = 1.0;
+                if (!validRect(r, dynamic.size())) return 1;
+                weighted |= w != 1.0;
+                dynamic.insert(r, w);
+                ++live;
+            } else if (op == '-' && fields >> id) {
+                if (!dynamic.erase(id)) {
+                    cerr << "Error: line " << lineNo << " of " << updates << " deletes " << id << ", which is not in the instance.\n";
+                    return 1;
                 }
-            }
-
-            if (canAdd) {
-                currentSol.push_back(i);
-                isSelected[i] = true;
-                improved = true; // Restart search immediately after improvement
-                break; 
+                --live;
+            } else {
+                cerr << "Error: line " << lineNo << " of " << updates << " must be \"+ x1 y1 x2 y2 [weight]\" or \"- id\".\n";
+                return 1;
             }
         }
-        if (improved) continue;
-
-        // --- 3. Try (1, 2) Swaps ---
-        // Find 1 rectangle in Solution (r_out) and 2 outside (r_in1, r_in2) such that removing r_out allows r_in1 and r_in2 to fit.
-        
-        for (int r_out_idx = 0; r_out_idx < currentSol.size(); ++r_out_idx) {
-            int u = currentSol[r_out_idx]; // The candidate to remove
-
-            // Candidates to insert: must not be in set, and must ONLY conflict with u (or nothing)
-            // within the current solution.
-            vector<int> candidates;
-            
-            for (int v = 0; v < n; v++) {
-                if (isSelected[v]) continue;
-
-                // Check conflicts with *other* members of solution
-                bool blockedByOthers = false;
-                for (int solId : currentSol) {
-                    if (solId == u) continue; // Ignore the one we might remove
-                    if (overlap(rects[v], rects[solId])) {
-                        blockedByOthers = true;
-                        break;
-                    }
-                }
-                if (!blockedByOthers) {
-                    candidates.push_back(v);
-                }
-            }
+        sol = Solution();
+        sol.selected = dynamic.selected();
+        sol.stats.value = dynamic.value();
+        sol.stats.seconds = clock.elapsed();
+        if (stats) writeStatsJson(stderr, "local", live, sol);
+
+        cout << "Rectangles selected: " << sol.selected.size() << endl;
+        if (weighted) cout << "Total weight: " << sol.stats.value << endl;
+        for (int id : sol.selected) cout << id << " ";
+        cout << endl;
+        return 0;
+    }
 
-            // Now look for a non-overlapping pair in 'candidates'
-            for (int i = 0; i < candidates.size(); ++i) {
-                for (int j = i + 1; j < candidates.size(); ++j) {
-                    int c1 = candidates[i];
-                    int c2 = candidates[j];
+    // --- Input ---
+    Solution sol;
+    int status = read(sol);
+    if (status == 0) cerr << "Error: first line must be a positive integer n.\n";
+    if (status != 1) return 1;
 
-                    if (!overlap(rects[c1], rects[c2])) {
-                        // Found a valid (1, 2) swap!
-                        // Remove u
-                        isSelected[u] = false;
-                        currentSol.erase(currentSol.begin() + r_out_idx);
-                        
-                        // Add c1, c2
-                        isSelected[c1] = true;
-                        isSelected[c2] = true;
-                        currentSol.push_back(c1);
-                        currentSol.push_back(c2);
-
-                        improved = true;
-                        goto end_loop; // Break out of nested loops
-                    }
-                }
-            }
-        }
-        end_loop:;
-    }
+    if (stats) writeStatsJson(stderr, "local", count(), sol, readTimes);
+    const vector<int> &currentSol = sol.selected;
+    if (sol.stats.timedOut) cerr << "Note: time limit reached; returning the best solution found.\n";
 
     // --- Output ---
     cout << "Rectangles selected: " << currentSol.size() << endl;
+    if (inst.weighted || streamWeighted) cout << "Total weight: " << sol.stats.value << endl;
     // Optional: Print indices if needed for debugging
     for(int id : currentSol) cout << id << " ";
     cout << endl;
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,256 @@
+/*
+ * Library API shared by the MISR solvers.
+ *
+ * Instance is the one input type of solve_ilp (ilp_solver.h), solve_local (local_solver.h) and
+ * solve_guillotine (guillotine_solver.h). Besides the rectangles and weights it holds the
+ * coordinate compression, computed once by compress(): every coordinate replaced by its rank
+ * among the distinct x (or y) values. Interiors intersect iff their ranks do, so the conflict
+ * graph, the point cliques and the guillotine DP all run on the int32 ranks; only the geometry
+ * dependent greedy orders of the local search read the original coordinates.
+ *
+ * Fill rects (and weights, or leave them empty for all 1) and call compress(), or use
+ * readInstance, which does both; streamInstance hands the rectangles over one by one instead
+ * (StripSolver). Each solver returns a Solution: the selected rectangle ids, sorted, and
+ * SolveStats, which writeStatsJson prints (--stats).
+ *
+ * The three CLIs are thin wrappers around these calls, and misr_bench.cpp uses them in-process.
+ */
+
+#ifndef MISR_MISR_H
+#define MISR_MISR_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <utility>
+#include <vector>
+#include "counters.h"
+#include "instance.h"
+#include "phase_times.h"
+#include "rect_store.h"
+
+struct InstanceRect { double x1, y1, x2, y2; };
+struct RankRect { int x1, y1, x2, y2; };   // indices into Instance::xs / Instance::ys
+
+struct Instance {
+    std::vector<InstanceRect> rects;
+    std::vector<double> weights;     // one per rectangle after compress()
+    bool weighted = false;           // some weight differs from 1
+
+    std::vector<double> xs, ys;      // sorted distinct coordinates
+    std::vector<RankRect> ranks;     // rects[i] in compressed coordinates
+
+    Instance() = default;
+    explicit Instance(std::vector<InstanceRect> r, std::vector<double> w = {}) : rects(std::move(r)), weights(std::move(w)) {
+        compress();
+    }
+
+    int size() const { return (int)rects.size(); }
+
+    // Fills weights (1 where missing), weighted, xs, ys and ranks from rects
+    void compress() {
+        const size_t n = rects.size();
+        weights.resize(n, 1.0);
+        weighted = false;
+        for (double w : weights) weighted |= w != 1.0;
+
+        ranks.resize(n);
+        compressAxis(&InstanceRect::x1, &InstanceRect::x2, &RankRect::x1, &RankRect::x2, xs);
+        compressAxis(&InstanceRect::y1, &InstanceRect::y2, &RankRect::y1, &RankRect::y2, ys);
+    }
+
+    double totalWeight(const std::vector<int> &ids) const {
+        double w = 0.0;
+        for (int i : ids) w += weights[i];
+        return w;
+    }
+
+private:
+    // Ranks of one axis. Integral coordinates spanning a range of O(n) (the usual grid instances)
+    // go through a direct-indexed table; others sort the 2n (value, slot) pairs once, which is
+    // still much cheaper than a binary search per coordinate.
+    void compressAxis(double InstanceRect::*lo, double InstanceRect::*hi, int RankRect::*rlo, int RankRect::*rhi,
+                      std::vector<double> &values) {
+        const size_t n = rects.size();
+        values.clear();
+        bool integral = true;
+        double minV = HUGE_VAL, maxV = -HUGE_VAL;
+        for (size_t i = 0; i < n && integral; ++i) {
+            integral = fitsInt32(rects[i].*lo) && fitsInt32(rects[i].*hi);
+            minV = std::min(minV, rects[i].*lo);
+            maxV = std::max(maxV, rects[i].*hi);
+        }
+        if (integral && n > 0 && maxV - minV <= 8.0 * n + 1024) {
+            const int64_t base = (int64_t)minV;
+            std::vector<int> rankOf((size_t)(maxV - minV) + 1, -1);
+            for (const InstanceRect &r : rects) rankOf[(int64_t)(r.*lo) - base] = rankOf[(int64_t)(r.*hi) - base] = 0;
+            for (size_t v = 0; v < rankOf.size(); ++v)
+                if (rankOf[v] == 0) { rankOf[v] = (int)values.size(); values.push_back((double)(base + (int64_t)v)); }
+            for (size_t i = 0; i < n; ++i) {
+                ranks[i].*rlo = rankOf[(int64_t)(rects[i].*lo) - base];
+                ranks[i].*rhi = rankOf[(int64_t)(rects[i].*hi) - base];
+            }
+            return;
+        }
+        std::vector<std::pair<double, uint32_t>> keys(2 * n);
+        for (size_t i = 0; i < n; ++i) {
+            keys[2 * i] = {rects[i].*lo, (uint32_t)(2 * i)};
+            keys[2 * i + 1] = {rects[i].*hi, (uint32_t)(2 * i + 1)};
+        }
+        std::sort(keys.begin(), keys.end());
+        for (const auto &k : keys) {
+            if (values.empty() || values.back() != k.first) values.push_back(k.first);
+            ranks[k.second / 2].*(k.second % 2 ? rhi : rlo) = (int)values.size() - 1;
+        }
+    }
+};
+
+struct SolveStats {
+    double value = 0.0;        // total weight of the selection (its size when unweighted)
+    double seconds = 0.0;      // wall time of the solve
+    bool timedOut = false;     // stopped at the time limit; the selection is the best one found
+    double phaseSeconds[PHASE_COUNT] = {};   // filled when the options ask for phase timings
+    uint64_t counters[CTR_COUNT] = {};       // event counts (counters.h); zero for other solvers' events
+};
+
+struct Solution {
+    int status = 0;            // 0 = solved, otherwise the solver's failure code (GLPK status for the ILP)
+    std::vector<int> selected; // sorted rectangle ids
+    SolveStats stats;
+};
+
+// Checks rectangle i of an instance, printing the reason when it is malformed
+inline bool validRect(const InstanceRect &r, size_t i) {
+    if (std::isfinite(r.x1) && std::isfinite(r.y1) && std::isfinite(r.x2) && std::isfinite(r.y2) && r.x1 < r.x2 && r.y1 < r.y2)
+        return true;
+    std::fprintf(stderr, "Error: rectangle %zu must satisfy x1 < x2 and y1 < y2.\n", i);
+    return false;
+}
+
+// Reads "n" followed by n rectangles "x1 y1 x2 y2 [weight]", as text or binary (instance.h), and
+// compresses it. Returns 1 on success, 0 if the input ended before n, and -1 (after printing the
+// reason) on malformed input. With phases, parsing and compression are timed separately.
+inline int readInstance(InstanceReader &in, Instance &inst, PhaseTimes *phases = nullptr) {
+    PhaseTimer timer(phases, PHASE_PARSE);
+    std::vector<InstanceRect> &rects = inst.rects;
+    std::vector<double> &weights = inst.weights;
+    auto valid = [&](size_t i) { return validRect(rects[i], i); };
+
+    if (in.atBinary()) {
+        BinaryHeader h;
+        const char *recs = in.readHeader(h) ? in.records(h) : nullptr;
+        if (!recs || h.count == 0 || h.count > (uint64_t)INT32_MAX) {
+            std::fprintf(stderr, "Error: truncated or empty binary instance.\n");
+            return -1;
+        }
+        rects.resize(h.count);
+        weights.resize(h.count);
+        for (size_t i = 0; i < rects.size(); ++i) {
+            BinaryRecord rec = in.record(recs, h, i);
+            rects[i] = {rec.coord(0), rec.coord(1), rec.coord(2), rec.coord(3)};
+            weights[i] = rec.weight();
+            if (!valid(i)) return -1;
+        }
+    } else {
+        int n;
+        if (!in.next(n)) {
+            if (in.done()) return 0;
+            std::fprintf(stderr, "Error: first line must be a positive integer n.\n");
+            return -1;
+        }
+        if (n <= 0) {
+            std::fprintf(stderr, "Error: first line must be a positive integer n.\n");
+            return -1;
+        }
+        rects.resize(n);
+        weights.resize(n);
+        for (int i = 0; i < n; ++i) {
+            InstanceRect &r = rects[i];
+            if (!(in.next(r.x1) && in.next(r.y1, true) && in.next(r.x2, true) && in.next(r.y2, true))) {
+                std::fprintf(stderr, "Error: line %d must have 4 coordinates (x1 y1 x2 y2 [weight]).\n", i + 2);
+                return -1;
+            }
+            if (!in.next(weights[i], true)) weights[i] = 1.0;   // optional weight
+            if (!valid(i)) return -1;
+        }
+    }
+
+    timer.next(PHASE_COMPRESS);
+    inst.compress();
+    return 1;
+}
+
+// Reads one instance like readInstance, but hands every rectangle to push(i, rect, weight)
+// instead of storing it, so the caller decides what to keep (StripSolver, --stream). Binary
+// records are consumed in chunks, so a pipe never buffers the whole instance. Returns 1, 0 or
+// -1 like readInstance; push returning false stops the read with -1.
+template <class Push>
+int streamInstance(InstanceReader &in, Push &&push) {
+    if (in.atBinary()) {
+        BinaryHeader h;
+        if (!in.readHeader(h) || h.count == 0 || h.count > (uint64_t)INT32_MAX) {
+            std::fprintf(stderr, "Error: truncated or empty binary instance.\n");
+            return -1;
+        }
+        for (uint64_t done = 0; done < h.count;) {
+            BinaryHeader chunk = h;
+            chunk.count = std::min<uint64_t>(h.count - done, 4096);
+            const char *recs = in.records(chunk);
+            if (!recs) {
+                std::fprintf(stderr, "Error: truncated or empty binary instance.\n");
+                return -1;
+            }
+            for (size_t k = 0; k < chunk.count; ++k, ++done) {
+                BinaryRecord rec = in.record(recs, chunk, k);
+                InstanceRect r{rec.coord(0), rec.coord(1), rec.coord(2), rec.coord(3)};
+                if (!validRect(r, done) || !push((int)done, r, rec.weight())) return -1;
+            }
+        }
+        return 1;
+    }
+    int n;
+    if (!in.next(n)) {
+        if (in.done()) return 0;
+        std::fprintf(stderr, "Error: first line must be a positive integer n.\n");
+        return -1;
+    }
+    if (n <= 0) {
+        std::fprintf(stderr, "Error: first line must be a positive integer n.\n");
+        return -1;
+    }
+    for (int i = 0; i < n; ++i) {
+        InstanceRect r;
+        double w;
+        if (!(in.next(r.x1) && in.next(r.y1, true) && in.next(r.x2, true) && in.next(r.y2, true))) {
+            std::fprintf(stderr, "Error: line %d must have 4 coordinates (x1 y1 x2 y2 [weight]).\n", i + 2);
+            return -1;
+        }
+        if (!in.next(w, true)) w = 1.0;
+        if (!validRect(r, i) || !push(i, r, w)) return -1;
+    }
+    return 1;
+}
+
+// One JSON object (one line) with the stats of a solve of n rectangles: value, time, phases and
+// counters. With `reading` (the PhaseTimes given to readInstance) the parse and compress phases
+// come from it.
+inline void writeStatsJson(std::FILE *out, const char *solver, int n, const Solution &sol,
+                           const PhaseTimes *reading = nullptr) {
+    const SolveStats &st = sol.stats;
+    std::fprintf(out, "{\"solver\": \"%s\", \"n\": %d, \"status\": %d, \"selected\": %zu, \"value\": %.17g, "
+                      "\"seconds\": %.6f, \"timed_out\": %s, \"phases\": {",
+                 solver, n, sol.status, sol.selected.size(), st.value, st.seconds, st.timedOut ? "true" : "false");
+    for (int p = 0; p < PHASE_COUNT; ++p) {
+        double s = st.phaseSeconds[p];
+        if (reading && (p == PHASE_PARSE || p == PHASE_COMPRESS)) s = reading->seconds(p);
+        std::fprintf(out, "%s\"%s\": %.6f", p ? ", " : "", phaseName(p), s);
+    }
+    std::fprintf(out, "}, \"counters_enabled\": %s, \"counters\": {", COUNTERS_ENABLED ? "true" : "false");
+    for (int c = 0; c < CTR_COUNT; ++c)
+        std::fprintf(out, "%s\"%s\": %llu", c ? ", " : "", counterName(c), (unsigned long long)st.counters[c]);
+    std::fprintf(out, "}}\n");
+    std::fflush(out);
+}
+
+#endif // MISR_MISR_H
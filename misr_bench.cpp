@@ -0,0 +1,263 @@
+/*
+ * Benchmark harness for the three MISR solvers.
+ *
+ * The solvers are called through their library API (misr.h), so an instance is generated
+ * in-process, written once to an unlinked temporary file and then read (the mmap path of
+ * instance.h) and solved by every selected solver, without process startup. Each (solver,
+ * instance) pair runs --warmup untimed and --reps timed times, reusing the solver workspace as
+ * --batch does; the CSV reports the median wall time of the whole run (reading included) and of
+ * each phase of phase_times.h. Phases that run inside parallel tasks sum their
+ * thread time, so compare phase columns at --threads 1.
+ *
+ * Generators (grid_size = 2n, as in testing.py):
+ *   uniform    testing.py's generate_rectangles: sides in [grid/10, grid/3], anywhere
+ *   clustered  the same sides halved, around n/8 normally distributed centers
+ *   overlap    sides in [grid/3, 2 grid/3], so most pairs overlap
+ *   strips     alternating horizontal and vertical strips, 1..grid/20 thick, grid/2..grid long
+ *
+ * Output: CSV on stdout. The first ten columns are those of experiment_results.csv (with the
+ * statuses "ok", "time_limit", "error" or "skipped"), followed by the generator, the local search
+ * columns and <solver>_<phase> medians in seconds.
+ *
+ * Usage: ./misr_bench [--generators uniform,clustered,overlap,strips] [--sizes 40,50] [--trials T]
+ *                     [--warmup W] [--reps R] [--seed S] [--solvers ilp,local,guillotine]
+ *                     [--threads N] [--time-limit S] > bench.csv
+ */
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "guillotine_solver.h"
+#include "ilp_solver.h"
+#include "local_solver.h"
+#include "misr.h"
+
+using namespace std;
+
+using Box4 = array<long long, 4>;   // x1 y1 x2 y2
+
+static long long randint(mt19937_64 &rng, long long lo, long long hi) {
+    return uniform_int_distribution<long long>(lo, hi)(rng);
+}
+
+// Lower-left corner for a w x h rectangle at (x, y), clamped into the grid
+static Box4 placed(long long x, long long y, long long w, long long h, long long grid) {
+    x = clamp(x, 0LL, max(0LL, grid - w));
+    y = clamp(y, 0LL, max(0LL, grid - h));
+    return {x, y, x + w, y + h};
+}
+
+static vector<Box4> generate(const string &kind, int n, long long grid, mt19937_64 &rng) {
+    const long long maxDim = max(1LL, grid / 3), minDim = max(1LL, grid / 10);
+    vector<Box4> rects;
+    rects.reserve(n);
+    if (kind == "uniform") {
+        for (int i = 0; i < n; ++i) {
+            long long w = randint(rng, minDim, maxDim), h = randint(rng, minDim, maxDim);
+            rects.push_back(placed(randint(rng, 0, max(0LL, grid - w)), randint(rng, 0, max(0LL, grid - h)), w, h, grid));
+        }
+    } else if (kind == "clustered") {
+        vector<pair<double, double>> centers(max(1, n / 8));
+        for (auto &c : centers) c = {(double)randint(rng, 0, grid), (double)randint(rng, 0, grid)};
+        normal_distribution<double> offset(0.0, grid / 12.0);
+        for (int i = 0; i < n; ++i) {
+            long long w = randint(rng, minDim, max(minDim, maxDim / 2)), h = randint(rng, minDim, max(minDim, maxDim / 2));
+            const auto &c = centers[randint(rng, 0, centers.size() - 1)];
+            rects.push_back(placed(llround(c.first + offset(rng)) - w / 2, llround(c.second + offset(rng)) - h / 2, w, h, grid));
+        }
+    } else if (kind == "overlap") {
+        for (int i = 0; i < n; ++i) {
+            long long w = randint(rng, maxDim, max(maxDim, 2 * grid / 3)), h = randint(rng, maxDim, max(maxDim, 2 * grid / 3));
+            rects.push_back(placed(randint(rng, 0, grid), randint(rng, 0, grid), w, h, grid));
+        }
+    } else {   // strips
+        for (int i = 0; i < n; ++i) {
+            long long len = randint(rng, max(1LL, grid / 2), max(1LL, grid)), thick = randint(rng, 1, max(1LL, grid / 20));
+            long long w = i % 2 ? thick : len, h = i % 2 ? len : thick;
+            rects.push_back(placed(randint(rng, 0, grid), randint(rng, 0, grid), w, h, grid));
+        }
+    }
+    return rects;
+}
+
+struct BenchOptions {
+    vector<string> generators{"uniform", "clustered", "overlap", "strips"};
+    vector<int> sizes{40, 50};
+    vector<string> solvers{"ilp", "local", "guillotine"};
+    int trials = 3;
+    int warmup = 1;
+    int reps = 3;
+    uint64_t seed = 1;
+    int threads = 1;
+    double timeLimit = -1;   // per solve, < 0 = none
+};
+
+struct Measurement {
+    bool run = false;
+    string status = "skipped";
+    int score = -1;
+    double total = 0, phase[PHASE_COUNT] = {};
+};
+
+static double median(vector<double> v) {
+    if (v.empty()) return 0.0;
+    sort(v.begin(), v.end());
+    return v.size() % 2 ? v[v.size() / 2] : 0.5 * (v[v.size() / 2 - 1] + v[v.size() / 2]);
+}
+
+// Reads the instance file fd and runs solve(instance) -> Solution, warmup + reps times
+template <class Solve>
+static Measurement measure(int fd, const BenchOptions &bo, Solve &&solve) {
+    Measurement m;
+    m.run = true;
+    vector<double> totals, phases[PHASE_COUNT];
+    Instance inst;
+    for (int rep = 0; rep < bo.warmup + bo.reps; ++rep) {
+        PhaseTimes reading;
+        auto start = chrono::steady_clock::now();
+        Solution sol;
+        {
+            InstanceReader in(fd);
+            if (readInstance(in, inst, &reading) != 1) { m.status = "error"; return m; }
+            sol = solve(inst);
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        if (sol.status != 0) { m.status = "error"; return m; }
+        m.score = sol.selected.size();
+        m.status = sol.stats.timedOut ? "time_limit" : "ok";
+        if (rep < bo.warmup) continue;
+        totals.push_back(seconds);
+        for (int p = 0; p < PHASE_COUNT; ++p) phases[p].push_back(reading.seconds(p) + sol.stats.phaseSeconds[p]);
+    }
+    m.total = median(totals);
+    for (int p = 0; p < PHASE_COUNT; ++p) m.phase[p] = median(phases[p]);
+    return m;
+}
+
+static vector<string> splitList(const string &s) {
+    vector<string> out;
+    stringstream ss(s);
+    for (string item; getline(ss, item, ',');) if (!item.empty()) out.push_back(item);
+    return out;
+}
+
+static string scoreText(const Measurement &m) { return m.score >= 0 && m.status != "error" ? to_string(m.score) : "-"; }
+static string timeText(const Measurement &m, double t) {
+    if (!m.run || m.status == "error") return "-";
+    char buf[32];
+    snprintf(buf, sizeof buf, "%.6f", t);
+    return buf;
+}
+
+int main(int argc, char **argv) {
+    BenchOptions bo;
+    for (int a = 1; a < argc; ++a) {
+        string arg = argv[a];
+        if (arg == "--generators" && a + 1 < argc) bo.generators = splitList(argv[++a]);
+        else if (arg == "--sizes" && a + 1 < argc) {
+            bo.sizes.clear();
+            for (const string &s : splitList(argv[++a])) bo.sizes.push_back(atoi(s.c_str()));
+        }
+        else if (arg == "--solvers" && a + 1 < argc) bo.solvers = splitList(argv[++a]);
+        else if (arg == "--trials" && a + 1 < argc) bo.trials = atoi(argv[++a]);
+        else if (arg == "--warmup" && a + 1 < argc) bo.warmup = max(0, atoi(argv[++a]));
+        else if (arg == "--reps" && a + 1 < argc) bo.reps = max(1, atoi(argv[++a]));
+        else if (arg == "--seed" && a + 1 < argc) bo.seed = strtoull(argv[++a], nullptr, 10);
+        else if (arg == "--threads" && a + 1 < argc) bo.threads = atoi(argv[++a]);
+        else if (arg == "--time-limit" && a + 1 < argc) bo.timeLimit = atof(argv[++a]);
+        else {
+            cerr << "Usage: " << argv[0] << " [--generators uniform,clustered,overlap,strips] [--sizes 40,50]"
+                    " [--trials T] [--warmup W] [--reps R] [--seed S] [--solvers ilp,local,guillotine]"
+                    " [--threads N] [--time-limit S] > bench.csv\n";
+            return 1;
+        }
+    }
+    const vector<string> kinds{"uniform", "clustered", "overlap", "strips"}, names{"ilp", "local", "guillotine"};
+    for (const string &g : bo.generators)
+        if (find(kinds.begin(), kinds.end(), g) == kinds.end()) {
+            cerr << "Error: unknown generator '" << g << "' (uniform, clustered, overlap, strips).\n";
+            return 1;
+        }
+    for (const string &s : bo.solvers)
+        if (find(names.begin(), names.end(), s) == names.end()) {
+            cerr << "Error: unknown solver '" << s << "' (ilp, local, guillotine).\n";
+            return 1;
+        }
+    for (int n : bo.sizes)
+        if (n <= 0) { cerr << "Error: --sizes must be positive.\n"; return 1; }
+    auto enabled = [&](const string &s) { return find(bo.solvers.begin(), bo.solvers.end(), s) != bo.solvers.end(); };
+
+    // Workspaces live across all instances, as in --batch mode
+    ilp_solver::Workspace ilpWs;
+    ilp_solver::Options ilpOpts;
+    ilpOpts.threads = bo.threads;
+    ilpOpts.timeLimit = bo.timeLimit;
+    ilpOpts.timePhases = true;
+    local_solver::Workspace localWs;
+    local_solver::Options localOpts;
+    localOpts.threads = bo.threads;
+    localOpts.timeLimit = bo.timeLimit;
+    localOpts.timePhases = true;
+    vector<guillotine_solver::Workspace> guillWs;
+    guillotine_solver::Options guillOpts;
+    guillOpts.threads = bo.threads;
+    guillOpts.timeLimit = bo.timeLimit;
+    guillOpts.timePhases = true;
+
+    printf("trial,n_rectangles,grid_size,ilp_score,guillotine_score,ratio,ilp_time,guillotine_time,ilp_status,"
+           "guillotine_status,generator,local_score,local_time,local_status");
+    for (const char *solver : {"ilp", "guillotine", "local"})
+        for (int p = 0; p < PHASE_COUNT; ++p) printf(",%s_%s", solver, phaseName(p));
+    printf("\n");
+
+    for (const string &kind : bo.generators) {
+        const size_t kindId = find(kinds.begin(), kinds.end(), kind) - kinds.begin();
+        for (int n : bo.sizes) {
+            for (int trial = 1; trial <= bo.trials; ++trial) {
+                // Seeded per (generator, size, trial), so changing the other lists keeps this instance
+                seed_seq seq{(uint64_t)bo.seed, (uint64_t)kindId, (uint64_t)n, (uint64_t)trial};
+                mt19937_64 rng(seq);
+                const long long grid = 2LL * n;
+                vector<Box4> rects = generate(kind, n, grid, rng);
+
+                FILE *file = tmpfile();
+                if (!file) { cerr << "Error: cannot create a temporary file.\n"; return 1; }
+                fprintf(file, "%d\n", n);
+                for (const Box4 &r : rects) fprintf(file, "%lld %lld %lld %lld\n", r[0], r[1], r[2], r[3]);
+                fflush(file);
+                const int fd = fileno(file);
+
+                Measurement ilp, local, guill;
+                if (enabled("ilp")) ilp = measure(fd, bo, [&](const Instance &inst) { return solve_ilp(inst, ilpOpts, &ilpWs); });
+                if (enabled("local")) local = measure(fd, bo, [&](const Instance &inst) { return solve_local(inst, localOpts, &localWs); });
+                if (enabled("guillotine"))
+                    guill = measure(fd, bo, [&](const Instance &inst) { return solve_guillotine(inst, guillOpts, &guillWs); });
+                fclose(file);
+
+                // The ratio is only meaningful when both solvers finished exactly
+                string ratio = "-";
+                if (ilp.status == "ok" && guill.status == "ok" && guill.score > 0) {
+                    char buf[32];
+                    snprintf(buf, sizeof buf, "%.4f", (double)ilp.score / guill.score);
+                    ratio = buf;
+                } else if (ilp.status == "ok" && guill.status == "ok" && ilp.score == 0) {
+                    ratio = "1.0000";
+                }
+                printf("%d,%d,%lld,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s", trial, n, grid, scoreText(ilp).c_str(),
+                       scoreText(guill).c_str(), ratio.c_str(), timeText(ilp, ilp.total).c_str(),
+                       timeText(guill, guill.total).c_str(), ilp.status.c_str(), guill.status.c_str(), kind.c_str(),
+                       scoreText(local).c_str(), timeText(local, local.total).c_str(), local.status.c_str());
+                for (const Measurement *m : {&ilp, &guill, &local})
+                    for (int p = 0; p < PHASE_COUNT; ++p) printf(",%s", timeText(*m, m->phase[p]).c_str());
+                printf("\n");
+                fflush(stdout);
+            }
+        }
+    }
+    return 0;
+}
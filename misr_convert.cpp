@@ -0,0 +1,61 @@
+/*
+ * Converts text MISR instances ("n" + n lines "x1 y1 x2 y2 [weight]") into the binary format
+ * of instance.h. Several concatenated instances become concatenated binary instances, which the
+ * solvers read back with --batch.
+ *
+ * Coordinates are stored as int64 when all of them are integral, as float64 otherwise (or
+ * always with --float). Weights are stored only if some line has one.
+ *
+ * Usage: ./misr_convert [--float] < input.txt > input.bin
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "instance.h"
+
+using namespace std;
+
+int main(int argc, char** argv) {
+    bool forceFloat = false;
+    for (int a = 1; a < argc; ++a) {
+        string arg = argv[a];
+        if (arg == "--float") forceFloat = true;
+        else {
+            cerr << "Usage: " << argv[0] << " [--float] < input.txt > input.bin\n";
+            return 1;
+        }
+    }
+
+    InstanceReader in(0);
+    vector<double> coords, weights;
+    int count = 0;
+    while (!in.done()) {
+        int n;
+        if (!in.next(n) || n <= 0) {
+            cerr << "Error: instance " << count << " must start with a positive integer n.\n";
+            return 1;
+        }
+        coords.assign(4 * (size_t)n, 0.0);
+        weights.assign(n, 1.0);
+        bool weighted = false, integral = true;
+        for (int i = 0; i < n; ++i) {
+            double *c = &coords[4 * (size_t)i];
+            if (!(in.next(c[0]) && in.next(c[1], true) && in.next(c[2], true) && in.next(c[3], true))) {
+                cerr << "Error: instance " << count << ", rectangle " << i << " must have 4 coordinates.\n";
+                return 1;
+            }
+            weighted |= in.next(weights[i], true);
+            for (int k = 0; k < 4; ++k) integral &= std::trunc(c[k]) == c[k] && std::fabs(c[k]) < 9.0e18;
+        }
+        if (!weighted) weights.clear();
+        if (!writeBinaryInstance(stdout, coords, weights, forceFloat || !integral)) {
+            cerr << "Error: failed to write output.\n";
+            return 1;
+        }
+        ++count;
+    }
+    return 0;
+}
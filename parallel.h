@@ -0,0 +1,88 @@
+/*
+ * Minimal fork-join helpers shared by the MISR solvers.
+ *
+ * parallelFor hands out indices from a shared atomic counter, so uneven work items
+ * (e.g. DP rows of different widths) balance themselves across workers. runWorkers is the
+ * layer below: one call per worker thread, for work that needs per-thread setup and teardown
+ * (the ILP's GLPK environments), or for phases separated by a Barrier (the bottom-up guillotine
+ * DP's wavefronts), which keeps one set of threads for all of them.
+ */
+
+#ifndef MISR_PARALLEL_H
+#define MISR_PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Maps a requested thread count to an actual one (0 = one per hardware thread)
+inline int resolveThreads(int requested) {
+    if (requested > 0) return requested;
+    unsigned hw = std::thread::hardware_concurrency();
+    return hw ? (int)hw : 1;
+}
+
+// Runs fn(worker) once on each of `workers` threads, worker 0 on the calling thread, and waits
+// for all of them
+template <class Fn>
+void runWorkers(int workers, Fn &&fn) {
+    std::vector<std::thread> pool;
+    pool.reserve(std::max(workers - 1, 0));
+    for (int t = 1; t < workers; ++t) pool.emplace_back([&fn, t] { fn(t); });
+    fn(0);
+    for (auto &th : pool) th.join();
+}
+
+// Reusable barrier for a fixed set of threads (std::barrier needs C++20): wait() returns once
+// all of them have called it, after which the next round can begin
+class Barrier {
+public:
+    explicit Barrier(int threads) : threads(threads) {}
+
+    void wait() {
+        if (threads <= 1) return;
+        std::unique_lock<std::mutex> lock(m);
+        const size_t round = generation;
+        if (++arrived == threads) {
+            arrived = 0;
+            ++generation;
+            cv.notify_all();
+            return;
+        }
+        cv.wait(lock, [&] { return generation != round; });
+    }
+
+private:
+    std::mutex m;
+    std::condition_variable cv;
+    int threads, arrived = 0;
+    size_t generation = 0;
+};
+
+// Runs fn(i, worker) for every i in [0, count) on up to `threads` workers and waits for all of
+// them. worker in [0, threads) identifies the executing thread, e.g. to pick per-thread scratch.
+template <class Fn>
+void parallelForWorker(size_t count, int threads, Fn &&fn) {
+    int workers = (int)std::min<size_t>((size_t)std::max(threads, 1), count);
+    if (workers <= 1) {
+        for (size_t i = 0; i < count; ++i) fn(i, 0);
+        return;
+    }
+
+    std::atomic<size_t> next{0};
+    runWorkers(workers, [&](int w) {
+        for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < count; ) fn(i, w);
+    });
+}
+
+// Runs fn(i) for every i in [0, count) on up to `threads` workers and waits for all of them
+template <class Fn>
+void parallelFor(size_t count, int threads, Fn &&fn) {
+    parallelForWorker(count, threads, [&](size_t i, int) { fn(i); });
+}
+
+#endif // MISR_PARALLEL_H
@@ -0,0 +1,139 @@
+/*
+ * Per-phase wall-clock accounting for the solvers (used by misr_bench).
+ *
+ * A solve is split into the phases below; a solver that has no such step leaves it at zero.
+ * PhaseTimer adds the time from its construction to stop() (or destruction) to one phase of a
+ * PhaseTimes. With a null PhaseTimes it never reads the clock, so the CLIs pay one branch per
+ * phase. Times are atomic nanosecond sums: phases run inside parallel tasks (blocks, components,
+ * restarts) add up their thread time.
+ *
+ * Built with -DMISR_TRACE, every PhaseTimer span is also recorded, with or without a PhaseTimes,
+ * as a Chrome trace event and written at exit to $MISR_TRACE_FILE (default misr_trace.json),
+ * which chrome://tracing and Perfetto open. Without it the trace code is not compiled.
+ */
+
+#ifndef MISR_PHASE_TIMES_H
+#define MISR_PHASE_TIMES_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#ifdef MISR_TRACE
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <vector>
+#endif
+
+enum Phase {
+    PHASE_PARSE,         // reading the instance
+    PHASE_COMPRESS,      // coordinate compression and window indexes
+    PHASE_GRAPH,         // conflict graph, reductions, decomposition
+    PHASE_INIT,          // greedy start, model or memo setup
+    PHASE_SEARCH,        // local search, branch-and-bound, DP recursion
+    PHASE_RECONSTRUCT,   // turning the result back into input ids
+    PHASE_COUNT
+};
+
+inline const char *phaseName(int phase) {
+    static const char *const names[PHASE_COUNT] = {"parse", "compress", "graph", "init", "search", "reconstruct"};
+    return names[phase];
+}
+
+struct PhaseTimes {
+    std::atomic<int64_t> nanos[PHASE_COUNT] = {};
+
+    void add(Phase phase, std::chrono::nanoseconds d) { nanos[phase].fetch_add(d.count(), std::memory_order_relaxed); }
+    double seconds(int phase) const { return nanos[phase].load(std::memory_order_relaxed) * 1e-9; }
+    void clear() { for (auto &t : nanos) t.store(0, std::memory_order_relaxed); }
+};
+
+#ifdef MISR_TRACE
+constexpr bool TRACE_PHASES = true;
+
+// Spans of all threads, written as {"traceEvents": [...]} when the program exits
+class TraceLog {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static TraceLog &instance() {
+        static TraceLog log;
+        return log;
+    }
+
+    void span(Phase phase, Clock::time_point start, Clock::time_point end) {
+        static std::atomic<int> threads{0};
+        thread_local const int tid = threads++;
+        std::lock_guard<std::mutex> lock(mutex);
+        spans.push_back({phase, tid, start, end});
+    }
+
+    ~TraceLog() {
+        const char *path = std::getenv("MISR_TRACE_FILE");
+        std::FILE *out = std::fopen(path && *path ? path : "misr_trace.json", "w");
+        if (!out) return;
+        Clock::time_point origin = Clock::time_point::max();
+        for (const Span &s : spans) origin = std::min(origin, s.start);
+        std::fprintf(out, "{\"traceEvents\": [");
+        for (size_t i = 0; i < spans.size(); ++i) {
+            const Span &s = spans[i];
+            std::fprintf(out, "%s\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f}",
+                         i ? "," : "", phaseName(s.phase), s.tid, micros(s.start - origin), micros(s.end - s.start));
+        }
+        std::fprintf(out, "\n]}\n");
+        std::fclose(out);
+    }
+
+private:
+    struct Span { Phase phase; int tid; Clock::time_point start, end; };
+
+    std::mutex mutex;
+    std::vector<Span> spans;
+
+    static double micros(Clock::duration d) { return std::chrono::duration<double, std::micro>(d).count(); }
+};
+#else
+constexpr bool TRACE_PHASES = false;
+#endif
+
+class PhaseTimer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    PhaseTimer(PhaseTimes *times, Phase phase) : times(times), phase(phase), running(times || TRACE_PHASES) {
+        if (running) start = Clock::now();
+    }
+    ~PhaseTimer() { stop(); }
+    PhaseTimer(const PhaseTimer &) = delete;
+    PhaseTimer &operator=(const PhaseTimer &) = delete;
+
+    void stop() {
+        if (!running) return;
+        record(Clock::now());
+        running = false;
+    }
+    // Ends the current phase and starts `next` at the same instant
+    void next(Phase nextPhase) {
+        if (!running) return;
+        Clock::time_point now = Clock::now();
+        record(now);
+        phase = nextPhase;
+        start = now;
+    }
+
+private:
+    PhaseTimes *times;
+    Phase phase;
+    bool running;
+    Clock::time_point start;
+
+    void record(Clock::time_point end) {
+        if (times) times->add(phase, end - start);
+#ifdef MISR_TRACE
+        TraceLog::instance().span(phase, start, end);
+#endif
+    }
+};
+
+#endif // MISR_PHASE_TIMES_H
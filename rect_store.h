@@ -0,0 +1,110 @@
+/*
+ * Structure-of-arrays rectangle storage and a block overlap kernel.
+ *
+ * RectSoA keeps x1 / y1 / x2 / y2 in separate 64-byte aligned int32 arrays. It is used when
+ * every coordinate is an integer that fits in int32 (fitsInt32), which covers the generated
+ * grid instances; the copies are then exact. Other inputs keep the scalar double test, since
+ * compressing them to ranks costs a sort that outweighs the faster kernel.
+ *
+ * overlapMask tests one rectangle against up to 16 consecutive stored ones: 16 lanes per
+ * instruction with AVX-512, 2 x 8 with AVX2, a scalar loop otherwise (chosen at compile time,
+ * as in bitset_kernel.h).
+ */
+
+#ifndef MISR_RECT_STORE_H
+#define MISR_RECT_STORE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+template <class T, size_t Align = 64>
+struct AlignedAllocator {
+    using value_type = T;
+    template <class U> struct rebind { using other = AlignedAllocator<U, Align>; };
+
+    AlignedAllocator() = default;
+    template <class U> AlignedAllocator(const AlignedAllocator<U, Align> &) {}
+
+    T *allocate(size_t n) {
+        void *p = std::aligned_alloc(Align, ((n * sizeof(T) + Align - 1) / Align) * Align);
+        if (!p) throw std::bad_alloc();
+        return static_cast<T *>(p);
+    }
+    void deallocate(T *p, size_t) { std::free(p); }
+
+    template <class U> bool operator==(const AlignedAllocator<U, Align> &) const { return true; }
+    template <class U> bool operator!=(const AlignedAllocator<U, Align> &) const { return false; }
+};
+
+using AlignedInts = std::vector<int32_t, AlignedAllocator<int32_t>>;
+
+// True if v is an integer that int32 represents exactly
+inline bool fitsInt32(double v) {
+    return std::trunc(v) == v && v >= -2147483648.0 && v <= 2147483647.0;
+}
+
+// Lanes past the last rectangle stay readable so the kernel can always load full blocks
+constexpr size_t RECT_SOA_PADDING = 16;
+
+struct RectSoA {
+    AlignedInts x1, y1, x2, y2;
+    size_t count = 0;
+
+    void resize(size_t n) {
+        count = n;
+        for (AlignedInts *a : {&x1, &y1, &x2, &y2}) a->assign(n + RECT_SOA_PADDING, 0);
+    }
+    void set(size_t i, int32_t ax1, int32_t ay1, int32_t ax2, int32_t ay2) {
+        x1[i] = ax1; y1[i] = ay1; x2[i] = ax2; y2[i] = ay2;
+    }
+};
+
+// Bit k is set iff stored rectangle from+k overlaps (qx1,qy1)-(qx2,qy2), for k < count <= 16.
+// Interiors must intersect: qx1 < x2, x1 < qx2 and the same in y.
+inline uint32_t overlapMask(int32_t qx1, int32_t qy1, int32_t qx2, int32_t qy2,
+                            const RectSoA &s, size_t from, int count) {
+#if defined(__AVX512F__) || defined(__AVX2__)
+    const uint32_t valid = count >= 16 ? 0xFFFFu : ((1u << count) - 1);
+#endif
+#if defined(__AVX512F__)
+    const __m512i ax1 = _mm512_set1_epi32(qx1), ay1 = _mm512_set1_epi32(qy1);
+    const __m512i ax2 = _mm512_set1_epi32(qx2), ay2 = _mm512_set1_epi32(qy2);
+    __mmask16 m = _mm512_cmplt_epi32_mask(ax1, _mm512_loadu_si512((const void *)(s.x2.data() + from)));
+    m = _mm512_mask_cmplt_epi32_mask(m, _mm512_loadu_si512((const void *)(s.x1.data() + from)), ax2);
+    m = _mm512_mask_cmplt_epi32_mask(m, ay1, _mm512_loadu_si512((const void *)(s.y2.data() + from)));
+    m = _mm512_mask_cmplt_epi32_mask(m, _mm512_loadu_si512((const void *)(s.y1.data() + from)), ay2);
+    return (uint32_t)m & valid;
+#elif defined(__AVX2__)
+    const __m256i ax1 = _mm256_set1_epi32(qx1), ay1 = _mm256_set1_epi32(qy1);
+    const __m256i ax2 = _mm256_set1_epi32(qx2), ay2 = _mm256_set1_epi32(qy2);
+    uint32_t mask = 0;
+    for (int half = 0; half < 2 && 8 * half < count; ++half) {
+        const size_t at = from + 8 * half;
+        __m256i bx1 = _mm256_loadu_si256((const __m256i *)(s.x1.data() + at));
+        __m256i by1 = _mm256_loadu_si256((const __m256i *)(s.y1.data() + at));
+        __m256i bx2 = _mm256_loadu_si256((const __m256i *)(s.x2.data() + at));
+        __m256i by2 = _mm256_loadu_si256((const __m256i *)(s.y2.data() + at));
+        __m256i m = _mm256_and_si256(_mm256_cmpgt_epi32(bx2, ax1), _mm256_cmpgt_epi32(ax2, bx1));
+        m = _mm256_and_si256(m, _mm256_and_si256(_mm256_cmpgt_epi32(by2, ay1), _mm256_cmpgt_epi32(ay2, by1)));
+        mask |= (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(m)) << (8 * half);
+    }
+    return mask & valid;
+#else
+    uint32_t mask = 0;
+    for (int k = 0; k < count && k < 16; ++k) {
+        const size_t i = from + k;
+        if (qx1 < s.x2[i] && s.x1[i] < qx2 && qy1 < s.y2[i] && s.y1[i] < qy2) mask |= 1u << k;
+    }
+    return mask;
+#endif
+}
+
+#endif // MISR_RECT_STORE_H
@@ -0,0 +1,125 @@
+/*
+ * Exact reduction rules (kernelization) for MISR, applied before the exact solvers.
+ *
+ * Every rule either fixes a rectangle into the solution or deletes one without losing an
+ * optimum, and the reduced instance stays a subset of the input rectangles, so the solvers
+ * can build their geometric models (clique rows, guillotine DP) on it unchanged:
+ *   - Simplicial: if the live neighbors of v form a clique (degree 0 and 1 included) and none
+ *     weighs more than v, some optimum takes v; take it and delete its neighbors.
+ *   - Domination: if u ~ v, N[v] ⊆ N[u] and w(v) >= w(u), swapping u for v never hurts; delete u.
+ *     A rectangle containing another one is the geometric special case.
+ * Rules are applied from a worklist until nothing changes. Vertex folding is not used, because a
+ * folded vertex is no longer a rectangle.
+ *
+ * containedRectangleReduction is the only rule that also preserves guillotine separability
+ * (the cuts isolating a rectangle isolate everything inside it), so the DP uses just that one.
+ */
+
+#ifndef MISR_REDUCE_H
+#define MISR_REDUCE_H
+
+#include <algorithm>
+#include <vector>
+#include "conflict_graph.h"
+
+// The reduced instance and the mapping back: reduced item i is original rectangle kept[i]
+struct Reduction {
+    std::vector<int> kept;    // undecided rectangles, sorted by original id
+    std::vector<int> taken;   // rectangles fixed into every solution, sorted
+
+    // Original ids of a solution of the reduced instance plus the fixed rectangles
+    std::vector<int> expand(const std::vector<int> &reducedSolution) const {
+        std::vector<int> ids(taken);
+        for (int i : reducedSolution) ids.push_back(kept[i]);
+        std::sort(ids.begin(), ids.end());
+        return ids;
+    }
+};
+
+// Neighborhood checks are quadratic in the live degree, so denser vertices are skipped
+constexpr int REDUCE_MAX_DEGREE = 64;
+
+// Applies the simplicial and domination rules to adj. weights may be empty (unweighted).
+inline Reduction reduceConflictGraph(const ConflictGraph &adj, const std::vector<double> &weights = {}) {
+    const int n = adj.size();
+    auto weight = [&](int v) { return weights.empty() ? 1.0 : weights[v]; };
+
+    std::vector<char> alive(n, 1), queued(n, 1);
+    std::vector<int> work(n), live;
+    for (int v = 0; v < n; ++v) work[v] = n - 1 - v;   // pop in increasing id order
+    Reduction red;
+
+    auto requeueAround = [&](int v) {
+        for (const int *p = adj.begin(v); p != adj.end(v); ++p)
+            if (alive[*p] && !queued[*p]) { queued[*p] = 1; work.push_back(*p); }
+    };
+    auto kill = [&](int v) { alive[v] = 0; requeueAround(v); };
+
+    while (!work.empty()) {
+        const int v = work.back();
+        work.pop_back();
+        queued[v] = 0;
+        if (!alive[v]) continue;
+
+        live.clear();
+        for (const int *p = adj.begin(v); p != adj.end(v); ++p)
+            if (alive[*p]) live.push_back(*p);
+        if (weight(v) <= 0) { kill(v); continue; }   // never improves a solution
+        if ((int)live.size() > REDUCE_MAX_DEGREE) continue;
+
+        // Simplicial: live neighborhood is a clique of no heavier rectangles
+        bool simplicial = true;
+        for (size_t a = 0; a < live.size() && simplicial; ++a) {
+            if (weight(live[a]) > weight(v)) simplicial = false;
+            for (size_t b = a + 1; b < live.size() && simplicial; ++b)
+                if (!adj.adjacent(live[a], live[b])) simplicial = false;
+        }
+        if (simplicial) {
+            alive[v] = 0;
+            red.taken.push_back(v);
+            for (int u : live) kill(u);
+            continue;
+        }
+
+        // Domination: delete every neighbor u with N[v] ⊆ N[u] that v outweighs
+        for (int u : live) {
+            if (!alive[u] || weight(u) > weight(v)) continue;
+            bool dominates = true;
+            for (int x : live)
+                if (x != u && alive[x] && !adj.adjacent(u, x)) { dominates = false; break; }
+            if (dominates) kill(u);
+        }
+    }
+
+    for (int v = 0; v < n; ++v)
+        if (alive[v]) red.kept.push_back(v);
+    std::sort(red.taken.begin(), red.taken.end());
+    return red;
+}
+
+// Deletes every rectangle that contains another one of at least its weight (of two identical
+// rectangles the heavier, then the lower id, stays). Containment implies overlap, so only
+// conflict edges need to be checked. weights may be empty (unweighted).
+template <class R>
+Reduction containedRectangleReduction(const std::vector<R> &rects, const ConflictGraph &adj,
+                                      const std::vector<double> &weights = {}) {
+    const int n = (int)rects.size();
+    auto weight = [&](int v) { return weights.empty() ? 1.0 : weights[v]; };
+    auto inside = [&](int b, int a) {   // b ⊆ a
+        return rects[a].x1 <= rects[b].x1 && rects[b].x2 <= rects[a].x2 &&
+               rects[a].y1 <= rects[b].y1 && rects[b].y2 <= rects[a].y2;
+    };
+    Reduction red;
+    for (int a = 0; a < n; ++a) {
+        bool container = false;
+        for (const int *p = adj.begin(a); p != adj.end(a) && !container; ++p) {
+            const int b = *p;
+            if (!inside(b, a) || weight(b) < weight(a)) continue;
+            container = weight(b) > weight(a) || !inside(a, b) || b < a;
+        }
+        if (!container) red.kept.push_back(a);
+    }
+    return red;
+}
+
+#endif // MISR_REDUCE_H
@@ -18,6 +18,7 @@ GUILL_EXECUTABLE = "./guillotine" if sys.platform != "win32" else "guillotine.ex
 
 ILP_TIMEOUT = 60.0              # seconds
 GUILL_TIMEOUT = 60.0            # seconds (N=50 can take ~30-40s)
+TIME_LIMIT_MARGIN = 2.0         # solvers stop this much before the timeout
 
 # REMOVED FIXED SEED to ensure new random instances every run
 # random.seed(42) 
@@ -53,11 +54,13 @@ def generate_rectangles(n, grid_size):
 def run_solver(executable, input_str, timeout):
     """
     Run a solver executable and extract the number of selected rectangles.
+    The solver gets --time-limit slightly below the timeout, so a slow run still
+    returns its best solution (status "time_limit") instead of being killed.
     """
     start_time = time.time()
     try:
         process = subprocess.run(
-            [executable],
+            [executable, "--time-limit", f"{max(timeout - TIME_LIMIT_MARGIN, 0.0):.1f}"],
             input=input_str,
             text=True,
             capture_output=True,
@@ -76,7 +79,8 @@ def run_solver(executable, input_str, timeout):
         )
         if match:
             score = int(match.group(1))
-            return score, elapsed_time, output, "ok"
+            status = "time_limit" if "time limit reached" in output else "ok"
+            return score, elapsed_time, output, status
 
         return None, elapsed_time, output, "parse_error"
 
@@ -134,13 +138,14 @@ def main():
             # 3. Calculate Ratio
             ratio = None
             note = ""
-            if ilp_score is not None and guill_score is not None and guill_score > 0:
+            exact = ilp_stat == "ok" and guill_stat == "ok"
+            if exact and ilp_score is not None and guill_score is not None and guill_score > 0:
                 ratio = ilp_score / guill_score
                 results.append(ratio)
                 if ratio > 1.000001:  # Floating point tolerance
                     note = "*** RATIO > 1 ***"
                     interesting_cases += 1
-            elif ilp_score == 0 and guill_score == 0:
+            elif exact and ilp_score == 0 and guill_score == 0:
                 ratio = 1.0
                 results.append(1.0)
             
@@ -152,6 +157,8 @@ def main():
             # If timeout, mark clearly
             if ilp_stat == "timeout" or guill_stat == "timeout":
                 note = "TIMEOUT"
+            elif ilp_stat == "time_limit" or guill_stat == "time_limit":
+                note = "TIME LIMIT"
 
             print(
                 f"{i+1:<6} | {n_rectangles:<4} | "
@@ -0,0 +1,73 @@
+/*
+ * Wall-clock budget and progress lines shared by the solvers (--time-limit, --progress).
+ *
+ * TimeBudget holds the start time and an optional deadline. Solvers poll expired() at cheap
+ * points (every few dozen moves, states or nodes) and return their best solution once it has
+ * passed. Progress prints at most one line per `interval` seconds on stderr, from whichever
+ * thread reports first:
+ *   progress: elapsed=1.50s best=123 states=456789 rate=304526/s
+ * stdout keeps the usual result format, so scripts parsing it are unaffected.
+ */
+
+#ifndef MISR_TIME_BUDGET_H
+#define MISR_TIME_BUDGET_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <mutex>
+
+struct TimeBudget {
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point start = Clock::now();
+    Clock::time_point deadline = Clock::time_point::max();
+
+    TimeBudget() = default;
+    explicit TimeBudget(double seconds) { if (seconds >= 0) limit(seconds); }
+
+    // Deadline `seconds` after start
+    void limit(double seconds) {
+        deadline = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+    }
+    bool limited() const { return deadline != Clock::time_point::max(); }
+    bool expired() const { return limited() && Clock::now() >= deadline; }
+    double elapsed() const { return std::chrono::duration<double>(Clock::now() - start).count(); }
+    // Seconds left, infinity without a limit
+    double remaining() const {
+        if (!limited()) return std::numeric_limits<double>::infinity();
+        double left = std::chrono::duration<double>(deadline - Clock::now()).count();
+        return left > 0 ? left : 0.0;
+    }
+};
+
+class Progress {
+public:
+    // interval <= 0 disables the lines
+    Progress(const TimeBudget &budget, double interval) : budget(budget), interval(interval), next(interval) {}
+
+    bool enabled() const { return interval > 0; }
+
+    // Prints a line if one is due. `work` counts the solver's unit (states, moves, nodes) so far.
+    void report(double best, uint64_t work, const char *unit) {
+        if (!enabled()) return;
+        const double now = budget.elapsed();
+        if (now < next.load(std::memory_order_relaxed)) return;
+        std::lock_guard<std::mutex> lock(mutex);
+        if (now < next.load(std::memory_order_relaxed)) return;
+        next.store(now + interval, std::memory_order_relaxed);
+        std::fprintf(stderr, "progress: elapsed=%.2fs best=%.10g %s=%llu rate=%.0f/s\n", now, best, unit,
+                     (unsigned long long)work, now > 0 ? work / now : 0.0);
+        std::fflush(stderr);
+    }
+
+private:
+    const TimeBudget &budget;
+    double interval;
+    std::atomic<double> next;
+    std::mutex mutex;
+};
+
+#endif // MISR_TIME_BUDGET_H